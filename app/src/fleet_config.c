@@ -0,0 +1,278 @@
+/*
+ * Frostbee - Versioned configuration cluster for group-addressed pushes
+ *
+ * Changing settings on a fleet of sleepy sensors one unicast write at a
+ * time queues one write per device at its parent.  Instead every sensor
+ * carries the Groups server and a cluster in the manufacturer-specific
+ * ID range (0xFC00, attributes without manufacturer code) on
+ * FROSTBEE_ENDPOINT, so one Write Attributes sent to a group reaches
+ * all members:
+ *
+ *   - Setting attributes (read intervals) are staged: a write only
+ *     changes the attribute storage.
+ *   - Writing ConfigVersion commits the staged set in one step: it is
+ *     copied to the active configuration, stored in the ZBOSS NVRAM
+ *     application dataset and handed to main.c.  Writes carry the
+ *     version last (highest attribute ID).
+ *   - Staging lasts for one Write Attributes command.  If a setting in
+ *     it is rejected, so is its version; afterwards the storage is reset
+ *     to the active set, so a setting written without a version is
+ *     dropped and reads always return what is in effect.
+ *   - A version equal to the active one is ignored, so repeated and
+ *     duplicated pushes are harmless.  A version write of 0 reverts to
+ *     the build defaults.
+ *
+ * Group-addressed frames are NWK broadcasts to rx-on-when-idle devices;
+ * sleepy end devices only receive them if their parent buffers them,
+ * which most coordinators/routers do not.  The host therefore reads
+ * ConfigVersion back and falls back to a unicast write for devices
+ * that missed the push (see zigbee2mqtt/frostbee.js).
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <zboss_api.h>
+
+#include "fleet_config.h"
+
+LOG_MODULE_REGISTER(fleet_config, LOG_LEVEL_INF);
+
+/* NVRAM dataset layout; bump when it changes */
+#define FLEET_NVRAM_VERSION  1
+
+struct fleet_nvram {
+	zb_uint8_t  nvram_version;
+	zb_uint8_t  reserved;
+	struct fleet_config cfg;
+} __packed;
+
+static fleet_config_cb_t applied_cb;
+
+/* Committed configuration, and the attribute storage staging the next */
+static struct fleet_config active;
+static struct fleet_config staged;
+
+static zb_uint8_t groups_name_support;
+
+/* Write Attributes command being processed */
+static bool batch_open;
+static bool batch_rejected;
+
+zb_zcl_attr_t fleet_groups_attr_list[FLEET_GROUPS_ATTR_COUNT] = {
+	{
+		ZB_ZCL_ATTR_GROUPS_NAME_SUPPORT_ID,
+		ZB_ZCL_ATTR_TYPE_8BITMAP,
+		ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+		(ZB_ZCL_NON_MANUFACTURER_SPECIFIC),
+		(void *)&groups_name_support
+	},
+	{
+		ZB_ZCL_NULL_ID,
+		0,
+		0,
+		(ZB_ZCL_NON_MANUFACTURER_SPECIFIC),
+		NULL
+	}
+};
+
+zb_zcl_attr_t fleet_config_attr_list[FLEET_CONFIG_ATTR_COUNT] = {
+	{
+		FROSTBEE_CONFIG_ATTR_READ_INTERVAL_ID,
+		ZB_ZCL_ATTR_TYPE_U16,
+		ZB_ZCL_ATTR_ACCESS_READ_WRITE,
+		(ZB_ZCL_NON_MANUFACTURER_SPECIFIC),
+		(void *)&staged.read_interval_s
+	},
+	{
+		FROSTBEE_CONFIG_ATTR_MAINS_READ_INTERVAL_ID,
+		ZB_ZCL_ATTR_TYPE_U16,
+		ZB_ZCL_ATTR_ACCESS_READ_WRITE,
+		(ZB_ZCL_NON_MANUFACTURER_SPECIFIC),
+		(void *)&staged.mains_read_interval_s
+	},
+	{
+		FROSTBEE_CONFIG_ATTR_VERSION_ID,
+		ZB_ZCL_ATTR_TYPE_U16,
+		ZB_ZCL_ATTR_ACCESS_READ_WRITE,
+		(ZB_ZCL_NON_MANUFACTURER_SPECIFIC),
+		(void *)&staged.version
+	},
+	{
+		ZB_ZCL_NULL_ID,
+		0,
+		0,
+		(ZB_ZCL_NON_MANUFACTURER_SPECIFIC),
+		NULL
+	}
+};
+
+/* ─── Commit ─── */
+
+static void fleet_config_commit(zb_uint16_t version)
+{
+	if (version == active.version) {
+		LOG_DBG("Config version %u already active", version);
+		/* The write stored the version; keep staging consistent */
+		staged.version = active.version;
+		return;
+	}
+
+	if (version == 0) {
+		/* Back to build defaults */
+		memset(&staged, 0, sizeof(staged));
+	}
+
+	staged.version = version;
+	active = staged;
+
+	if (zb_nvram_write_dataset(ZB_NVRAM_APP_DATA1) != RET_OK) {
+		LOG_ERR("Config version %u not persisted", version);
+	}
+
+	LOG_INF("Config version %u: read interval %u s, mains %u s",
+		active.version, active.read_interval_s,
+		active.mains_read_interval_s);
+
+	if (applied_cb != NULL) {
+		applied_cb(&active);
+	}
+}
+
+/* ─── Cluster handlers ─── */
+
+/* Scheduled from the first record of a command, so it runs once ZBOSS
+ * has processed all of its records
+ */
+static void fleet_config_batch_end(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	if (staged.read_interval_s != active.read_interval_s ||
+	    staged.mains_read_interval_s != active.mains_read_interval_s) {
+		LOG_WRN("Settings written without a new version - discarded");
+	}
+
+	staged = active;
+	batch_open = false;
+	batch_rejected = false;
+}
+
+static void fleet_config_batch_begin(void)
+{
+	if (batch_open) {
+		return;
+	}
+
+	/* Without the end callback, records are judged one by one */
+	batch_open = ZB_SCHEDULE_APP_CALLBACK(fleet_config_batch_end, 0) == RET_OK;
+	batch_rejected = false;
+}
+
+static zb_ret_t fleet_config_check_value(zb_uint16_t attr_id, zb_uint8_t endpoint,
+					 zb_uint8_t *value)
+{
+	ARG_UNUSED(endpoint);
+
+	fleet_config_batch_begin();
+
+	switch (attr_id) {
+	case FROSTBEE_CONFIG_ATTR_READ_INTERVAL_ID:
+	case FROSTBEE_CONFIG_ATTR_MAINS_READ_INTERVAL_ID: {
+		zb_uint16_t interval = sys_get_le16(value);
+
+		if (interval != 0 && interval < FROSTBEE_CONFIG_MIN_INTERVAL_S) {
+			batch_rejected = true;
+			return RET_ERROR;
+		}
+		return RET_OK;
+	}
+
+	case FROSTBEE_CONFIG_ATTR_VERSION_ID:
+		/* Never commit a partially accepted set */
+		if (batch_rejected) {
+			LOG_WRN("Config version %u refused: setting rejected",
+				sys_get_le16(value));
+			return RET_ERROR;
+		}
+		return RET_OK;
+
+	default:
+		return RET_OK;
+	}
+}
+
+/* Runs for every attribute written, in the order of the command */
+static void fleet_config_write_hook(zb_uint8_t endpoint, zb_uint16_t attr_id,
+				    zb_uint8_t *new_value, zb_uint16_t manuf_code)
+{
+	ARG_UNUSED(endpoint);
+	ARG_UNUSED(manuf_code);
+
+	if (attr_id == FROSTBEE_CONFIG_ATTR_VERSION_ID) {
+		fleet_config_commit(sys_get_le16(new_value));
+	}
+}
+
+void fleet_config_cluster_init(void)
+{
+	zb_zcl_add_cluster_handlers(ZB_ZCL_CLUSTER_ID_FROSTBEE_CONFIG,
+				    ZB_ZCL_CLUSTER_SERVER_ROLE,
+				    fleet_config_check_value,
+				    fleet_config_write_hook,
+				    (zb_zcl_cluster_handler_t)NULL);
+}
+
+/* ─── NVRAM application dataset ─── */
+
+static zb_uint16_t fleet_nvram_size(void)
+{
+	return sizeof(struct fleet_nvram);
+}
+
+static zb_ret_t fleet_nvram_write(zb_uint8_t page, zb_uint32_t pos)
+{
+	struct fleet_nvram data = {
+		.nvram_version = FLEET_NVRAM_VERSION,
+		.cfg = active,
+	};
+
+	return zb_osif_nvram_write(page, pos, &data, sizeof(data));
+}
+
+static void fleet_nvram_read(zb_uint8_t page, zb_uint32_t pos,
+			     zb_uint16_t payload_length)
+{
+	struct fleet_nvram data;
+
+	if (payload_length != sizeof(data) ||
+	    zb_osif_nvram_read(page, pos, (zb_uint8_t *)&data, sizeof(data)) != RET_OK ||
+	    data.nvram_version != FLEET_NVRAM_VERSION) {
+		LOG_WRN("Stored config ignored");
+		return;
+	}
+
+	active = data.cfg;
+	staged = active;
+
+	LOG_INF("Restored config version %u", active.version);
+
+	if (applied_cb != NULL) {
+		applied_cb(&active);
+	}
+}
+
+int fleet_config_init(fleet_config_cb_t applied)
+{
+	applied_cb = applied;
+
+	zb_nvram_register_app1_read_cb(fleet_nvram_read);
+	zb_nvram_register_app1_write_cb(fleet_nvram_write, fleet_nvram_size);
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Frostbee - Versioned configuration cluster for group-addressed pushes
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef FLEET_CONFIG_H
+#define FLEET_CONFIG_H 1
+
+#include <zboss_api.h>
+
+/** @brief Configuration committed by a version write (0 = build default). */
+struct fleet_config {
+	zb_uint16_t version;
+	zb_uint16_t read_interval_s;        /* Battery-mode sensor interval */
+	zb_uint16_t mains_read_interval_s;  /* Mains-mode sensor interval */
+};
+
+/** @brief Called in ZBOSS context when a configuration takes effect. */
+typedef void (*fleet_config_cb_t)(const struct fleet_config *cfg);
+
+#if defined(CONFIG_FROSTBEE_FLEET_CONFIG)
+
+/* Manufacturer-specific cluster ID range, but the attributes are not
+ * manufacturer-specific: frames must not carry a manufacturer code
+ */
+#define ZB_ZCL_CLUSTER_ID_FROSTBEE_CONFIG  0xFC00
+
+/* Attribute IDs.  The version has the highest ID so that a Write
+ * Attributes command listing attributes in ID order carries it last,
+ * after the values it commits.
+ */
+#define FROSTBEE_CONFIG_ATTR_READ_INTERVAL_ID        0x0000
+#define FROSTBEE_CONFIG_ATTR_MAINS_READ_INTERVAL_ID  0x0001
+#define FROSTBEE_CONFIG_ATTR_VERSION_ID              0x00FF
+
+/* Shortest interval accepted over the air (0 restores the default) */
+#define FROSTBEE_CONFIG_MIN_INTERVAL_S  5
+
+void fleet_config_cluster_init(void);
+
+#define ZB_ZCL_CLUSTER_ID_FROSTBEE_CONFIG_SERVER_ROLE_INIT  fleet_config_cluster_init
+#define ZB_ZCL_CLUSTER_ID_FROSTBEE_CONFIG_CLIENT_ROLE_INIT  ((zb_zcl_cluster_init_t)NULL)
+
+/* Attribute lists, including the ZB_ZCL_NULL_ID terminator */
+#define FLEET_CONFIG_ATTR_COUNT  4
+#define FLEET_GROUPS_ATTR_COUNT  2
+
+extern zb_zcl_attr_t fleet_config_attr_list[FLEET_CONFIG_ATTR_COUNT];
+extern zb_zcl_attr_t fleet_groups_attr_list[FLEET_GROUPS_ATTR_COUNT];
+
+/* Groups and Frostbee config servers on FROSTBEE_ENDPOINT */
+#define FLEET_CONFIG_CLUSTER_NUM  2
+
+#define FLEET_CONFIG_CLUSTER_IDS                                     \
+	ZB_ZCL_CLUSTER_ID_GROUPS,                                    \
+	ZB_ZCL_CLUSTER_ID_FROSTBEE_CONFIG,
+
+#define FLEET_CONFIG_CLUSTER_DESCS                                   \
+	ZB_ZCL_CLUSTER_DESC(                                         \
+		ZB_ZCL_CLUSTER_ID_GROUPS,                            \
+		ZB_ZCL_ARRAY_SIZE(fleet_groups_attr_list,            \
+				  zb_zcl_attr_t),                    \
+		(fleet_groups_attr_list),                            \
+		ZB_ZCL_CLUSTER_SERVER_ROLE,                          \
+		ZB_ZCL_MANUF_CODE_INVALID                            \
+	),                                                           \
+	ZB_ZCL_CLUSTER_DESC(                                         \
+		ZB_ZCL_CLUSTER_ID_FROSTBEE_CONFIG,                   \
+		ZB_ZCL_ARRAY_SIZE(fleet_config_attr_list,            \
+				  zb_zcl_attr_t),                    \
+		(fleet_config_attr_list),                            \
+		ZB_ZCL_CLUSTER_SERVER_ROLE,                          \
+		ZB_ZCL_MANUF_CODE_INVALID                            \
+	),
+
+/** @brief Register the NVRAM dataset; call before zigbee_enable().
+ *
+ * @p applied runs once the stored configuration has been loaded and
+ * again after every committed version.
+ */
+int fleet_config_init(fleet_config_cb_t applied);
+
+#else
+
+#define FLEET_CONFIG_CLUSTER_NUM  0
+#define FLEET_CONFIG_CLUSTER_IDS
+#define FLEET_CONFIG_CLUSTER_DESCS
+
+static inline int fleet_config_init(fleet_config_cb_t applied)
+{
+	ARG_UNUSED(applied);
+	return 0;
+}
+
+#endif /* CONFIG_FROSTBEE_FLEET_CONFIG */
+
+#endif /* FLEET_CONFIG_H */
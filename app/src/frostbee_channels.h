@@ -0,0 +1,144 @@
+/*
+ * Frostbee - Measurement channel table
+ *
+ * One entry per quantity measured by every SHT4x zone.  Attribute
+ * storage, attribute lists, cluster lists, simple descriptors, the
+ * cluster/report counts and the attribute update loop are all generated
+ * from this table, so a disabled channel leaves no code or data behind.
+ *
+ * Entry layout:
+ *
+ *   X(z, name, tag, value_attr, type, unknown, min, max, has_tol, tol,
+ *     report_cnt, attr_list, src, scale)
+ *
+ *   z           sensor index (0-based; zone z + 1), forwarded from FROSTBEE_CHANNELS()
+ *   name        identifier used for storage fields and attribute lists
+ *   tag         ZCL cluster suffix (ZB_ZCL_CLUSTER_ID_<tag>); passed
+ *               unexpanded because ZB_ZCL_CLUSTER_DESC() pastes the ID
+ *   value_attr  MeasuredValue attribute ID, set on every read
+ *   type        ZCL storage type of MeasuredValue/Min/Max
+ *   unknown     MeasuredValue until the first valid reading
+ *   min, max    MinMeasuredValue / MaxMeasuredValue
+ *   has_tol     1 if the cluster has a Tolerance attribute, else 0 (no
+ *               storage is generated for it)
+ *   tol         Tolerance value (ignored when has_tol is 0)
+ *   report_cnt  reportable attributes in the cluster
+ *   attr_list   FROSTBEE_ATTR_LIST_* declarator for the cluster
+ *   src         struct sht4x_sample field holding the raw ticks
+ *   scale       converts raw ticks to the ZCL value (0.01 units)
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef FROSTBEE_CHANNELS_H
+#define FROSTBEE_CHANNELS_H 1
+
+#include "sht4x_raw.h"
+
+/* Temperature measurement range: -40.00 C to +125.00 C (SHT40 spec) */
+#define FROSTBEE_TEMP_MIN_VALUE  (-4000)
+#define FROSTBEE_TEMP_MAX_VALUE  12500
+
+/* Humidity measurement range: 0.00% to 100.00% */
+#define FROSTBEE_HUM_MIN_VALUE   0
+#define FROSTBEE_HUM_MAX_VALUE   10000
+
+/* ─── Attribute list declarators ─── */
+
+#define FROSTBEE_ATTR_LIST_TEMP(list, ch)                            \
+	ZB_ZCL_DECLARE_TEMP_MEASUREMENT_ATTRIB_LIST(                 \
+		list,                                                \
+		&(ch).measure_value,                                 \
+		&(ch).min_value,                                     \
+		&(ch).max_value,                                     \
+		&(ch).tolerance)
+
+#define FROSTBEE_ATTR_LIST_HUM(list, ch)                             \
+	ZB_ZCL_DECLARE_REL_HUMIDITY_MEASUREMENT_ATTRIB_LIST(         \
+		list,                                                \
+		&(ch).measure_value,                                 \
+		&(ch).min_value,                                     \
+		&(ch).max_value)
+
+/* ─── Channels ─── */
+
+#if defined(CONFIG_FROSTBEE_CHANNEL_TEMPERATURE)
+#define FROSTBEE_CH_TEMPERATURE(X, z)                                \
+	X(z, temp, TEMP_MEASUREMENT,                                 \
+	  ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,                     \
+	  zb_int16_t, ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_UNKNOWN,    \
+	  FROSTBEE_TEMP_MIN_VALUE, FROSTBEE_TEMP_MAX_VALUE,          \
+	  1, 20, /* 0.2 C tolerance (SHT40 typical accuracy) */      \
+	  ZB_ZCL_TEMP_MEASUREMENT_REPORT_ATTR_COUNT,                 \
+	  FROSTBEE_ATTR_LIST_TEMP, t_ticks, SHT4X_TICKS_TO_TEMP)
+#else
+#define FROSTBEE_CH_TEMPERATURE(X, z)
+#endif
+
+#if defined(CONFIG_FROSTBEE_CHANNEL_HUMIDITY)
+#define FROSTBEE_CH_HUMIDITY(X, z)                                   \
+	X(z, hum, REL_HUMIDITY_MEASUREMENT,                          \
+	  ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,             \
+	  zb_uint16_t, ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_UNKNOWN, \
+	  FROSTBEE_HUM_MIN_VALUE, FROSTBEE_HUM_MAX_VALUE,            \
+	  0, 0, /* no Tolerance attribute */                         \
+	  ZB_ZCL_REL_HUMIDITY_MEASUREMENT_REPORT_ATTR_COUNT,         \
+	  FROSTBEE_ATTR_LIST_HUM, rh_ticks, SHT4X_TICKS_TO_HUM)
+#else
+#define FROSTBEE_CH_HUMIDITY(X, z)
+#endif
+
+/** @brief Expand X once per enabled channel of zone z. */
+#define FROSTBEE_CHANNELS(X, z)                                      \
+	FROSTBEE_CH_TEMPERATURE(X, z)                                \
+	FROSTBEE_CH_HUMIDITY(X, z)
+
+/* ─── Derived counts ─── */
+
+#define FROSTBEE_CH_COUNT_ONE(...)  + 1
+#define FROSTBEE_CH_REPORT_COUNT(z, name, tag, value_attr, type, unknown, \
+				 min, max, has_tol, tol, report_cnt, ...) \
+	+ (report_cnt)
+
+/* Enabled channels, i.e. measurement clusters per zone */
+#define FROSTBEE_CHANNEL_COUNT \
+	(0 FROSTBEE_CHANNELS(FROSTBEE_CH_COUNT_ONE, 0))
+
+/* Reportable attributes across all channels of one zone */
+#define FROSTBEE_CHANNEL_REPORT_ATTR_COUNT \
+	(0 FROSTBEE_CHANNELS(FROSTBEE_CH_REPORT_COUNT, 0))
+
+BUILD_ASSERT(FROSTBEE_CHANNEL_COUNT >= 1, "at least one measurement channel required");
+
+/* ─── Generators ─── */
+
+/** @brief Attribute list name of a channel in zone z. */
+#define FROSTBEE_CH_ATTR_LIST(z, name)  zone##z##_##name##_attr_list
+
+/** @brief Storage for one channel's attributes (Tolerance only if used). */
+#define FROSTBEE_CH_STORAGE(z, name, tag, value_attr, type, unknown, \
+			    min, max, has_tol, ...)                  \
+	struct {                                                     \
+		type        measure_value;                           \
+		type        min_value;                               \
+		type        max_value;                               \
+		IF_ENABLED(has_tol, (zb_uint16_t tolerance;))        \
+	} name;
+
+/** @brief Simple descriptor entry for a channel. */
+#define FROSTBEE_CH_CLUSTER_ID(z, name, tag, ...) \
+	ZB_ZCL_CLUSTER_ID_##tag,
+
+/** @brief Cluster list entry for a channel in zone z. */
+#define FROSTBEE_CH_CLUSTER_DESC(z, name, tag, ...)                  \
+	ZB_ZCL_CLUSTER_DESC(                                         \
+		ZB_ZCL_CLUSTER_ID_##tag,                             \
+		ZB_ZCL_ARRAY_SIZE(                                   \
+			FROSTBEE_CH_ATTR_LIST(z, name),              \
+			zb_zcl_attr_t),                              \
+		(FROSTBEE_CH_ATTR_LIST(z, name)),                    \
+		ZB_ZCL_CLUSTER_SERVER_ROLE,                          \
+		ZB_ZCL_MANUF_CODE_INVALID                            \
+	),
+
+#endif /* FROSTBEE_CHANNELS_H */
@@ -0,0 +1,176 @@
+/*
+ * Frostbee - Parent link monitoring and controlled re-parenting
+ *
+ * ZBOSS picks the parent during association and rejoin itself (best
+ * link cost / LQI among the beacons heard) and offers no hook to rank
+ * candidates from the application.  What the application can do is
+ * notice that the chosen parent has gone bad and ask for a new choice:
+ *
+ *   - Link failures reported through NLME-STATUS.indication (failed
+ *     polls to the parent, unreachable routes) are time-stamped.
+ *   - CONFIG_FROSTBEE_LINK_WATCH_FAILURES of them within
+ *     CONFIG_FROSTBEE_LINK_WATCH_WINDOW_S start a secure rejoin, which
+ *     scans again and attaches to the best parent currently in range.
+ *   - Rejoins are at least CONFIG_FROSTBEE_LINK_WATCH_HOLDOFF_S apart,
+ *     and the hold-off doubles (up to 8x) while rejoins do not help, so
+ *     a device with no better parent in range never thrashes.
+ *   - The rejoin runs under ZBOSS's rejoin backoff: a failed attempt
+ *     continues it, a successful one cancels it.
+ *
+ * While link watch handles a failure or owns a running rejoin, the
+ * signal is kept from zigbee_default_signal_handler(), which would
+ * otherwise start a rejoin of its own.  Failures during the hold-off
+ * are left to it, so a lost parent is always recovered.
+ *
+ * End devices only: a router keeps its links through the mesh.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <zboss_api.h>
+
+#include "link_watch.h"
+
+LOG_MODULE_REGISTER(link_watch, LOG_LEVEL_INF);
+
+#define FAILURES        CONFIG_FROSTBEE_LINK_WATCH_FAILURES
+#define WINDOW_MS       (CONFIG_FROSTBEE_LINK_WATCH_WINDOW_S * MSEC_PER_SEC)
+#define HOLDOFF_MS      (CONFIG_FROSTBEE_LINK_WATCH_HOLDOFF_S * MSEC_PER_SEC)
+#define MAX_BACKOFF     8
+
+/* Uptime of the last FAILURES link failures (ring buffer) */
+static int64_t failure_ts[FAILURES];
+static uint8_t failure_idx;
+static uint8_t failure_count;
+
+static bool joined;
+static int64_t last_rejoin;
+static uint8_t backoff = 1;
+
+static void failures_reset(void)
+{
+	failure_idx = 0;
+	failure_count = 0;
+}
+
+static bool is_link_failure(zb_uint8_t status)
+{
+	switch (status) {
+	case ZB_NWK_COMMAND_STATUS_PARENT_LINK_FAILURE:
+	case ZB_NWK_COMMAND_STATUS_TREE_LINK_FAILURE:
+	case ZB_NWK_COMMAND_STATUS_NONE_TREE_LINK_FAILURE:
+	case ZB_NWK_COMMAND_STATUS_NO_ROUTE_AVAILABLE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Returns true if the failure was handled here */
+static bool link_failure(zb_uint8_t status)
+{
+	int64_t now = k_uptime_get();
+	int64_t oldest;
+
+	failure_ts[failure_idx] = now;
+	failure_idx = (failure_idx + 1) % FAILURES;
+	if (failure_count < FAILURES) {
+		failure_count++;
+	}
+
+	LOG_DBG("Link failure 0x%02x (%u in window)", status, failure_count);
+
+	if (zb_zdo_rejoin_backoff_is_running()) {
+		return true;
+	}
+
+	if (failure_count < FAILURES) {
+		return true;
+	}
+
+	/* Ring is full: failure_idx points at the oldest entry */
+	oldest = failure_ts[failure_idx];
+	if (now - oldest > WINDOW_MS) {
+		return true;
+	}
+
+	/* A long quiet stretch means the last rejoin helped */
+	if (last_rejoin != 0 && now - last_rejoin > (int64_t)HOLDOFF_MS * MAX_BACKOFF * 2) {
+		backoff = 1;
+	}
+
+	if (last_rejoin != 0 && now - last_rejoin < (int64_t)HOLDOFF_MS * backoff) {
+		LOG_DBG("Link degraded, rejoin held off");
+		return false;
+	}
+
+	LOG_WRN("%u link failures in %lld s - rejoining for a better parent",
+		FAILURES, (now - oldest) / MSEC_PER_SEC);
+
+	failures_reset();
+	last_rejoin = now;
+	backoff = MIN(backoff * 2, MAX_BACKOFF);
+
+	/* Secure rejoin on the current network; ZBOSS rescans and picks
+	 * the parent with the best link cost.
+	 */
+	if (zb_zdo_rejoin_backoff_start(ZB_FALSE) != RET_OK) {
+		LOG_ERR("Rejoin could not be started");
+		return false;
+	}
+	return true;
+}
+
+bool link_watch_signal_handler(zb_bufid_t bufid)
+{
+	zb_zdo_app_signal_hdr_t *sig_hdr = NULL;
+	zb_zdo_app_signal_type_t sig = zb_get_app_signal(bufid, &sig_hdr);
+	zb_ret_t status = ZB_GET_APP_SIGNAL_STATUS(bufid);
+
+	switch (sig) {
+	case ZB_BDB_SIGNAL_DEVICE_REBOOT:
+	case ZB_BDB_SIGNAL_TC_REJOIN_DONE:
+		if (zb_zdo_rejoin_backoff_is_running()) {
+			if (status != RET_OK) {
+				/* Next attempt after the backoff delay */
+				LOG_DBG("Rejoin attempt failed, backing off");
+				ZB_SCHEDULE_APP_CALLBACK(zb_zdo_rejoin_backoff_continue, 0);
+				return true;
+			}
+			zb_zdo_rejoin_backoff_cancel();
+		}
+		/* fall-through */
+	case ZB_BDB_SIGNAL_STEERING:
+	case ZB_BDB_SIGNAL_DEVICE_FIRST_START:
+		joined = (status == RET_OK) &&
+			 (zb_get_network_role() == ZB_NWK_DEVICE_TYPE_ED);
+		failures_reset();
+		break;
+
+	case ZB_ZDO_SIGNAL_LEAVE:
+		if (zb_zdo_rejoin_backoff_is_running()) {
+			zb_zdo_rejoin_backoff_cancel();
+		}
+		joined = false;
+		break;
+
+	case ZB_NLME_STATUS_INDICATION: {
+		zb_zdo_signal_nlme_status_indication_params_t *params =
+			ZB_ZDO_SIGNAL_GET_PARAMS(sig_hdr,
+				zb_zdo_signal_nlme_status_indication_params_t);
+
+		if (joined && is_link_failure(params->nlme_status.status)) {
+			return link_failure(params->nlme_status.status);
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	return false;
+}
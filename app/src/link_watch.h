@@ -0,0 +1,32 @@
+/*
+ * Frostbee - Parent link monitoring and controlled re-parenting
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LINK_WATCH_H
+#define LINK_WATCH_H 1
+
+#include <stdbool.h>
+#include <zboss_api.h>
+
+#if defined(CONFIG_FROSTBEE_LINK_WATCH)
+
+/** @brief Feed ZBOSS signals; call first in zboss_signal_handler().
+ *
+ * @return true if link watch handled the signal and the default signal
+ *         handler must not see it (it would start a rejoin of its own).
+ */
+bool link_watch_signal_handler(zb_bufid_t bufid);
+
+#else
+
+static inline bool link_watch_signal_handler(zb_bufid_t bufid)
+{
+	ARG_UNUSED(bufid);
+	return false;
+}
+
+#endif /* CONFIG_FROSTBEE_LINK_WATCH */
+
+#endif /* LINK_WATCH_H */
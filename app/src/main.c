@@ -4,15 +4,18 @@
  * nRF52840 Dongle + Sensirion SHT40 via I2C
  * Zigbee Sleepy End Device with ZCL clusters:
  *   - Basic, Identify, Power Configuration
- *   - Temperature Measurement, Relative Humidity
+ *   - Temperature Measurement, Relative Humidity (frostbee_channels.h)
+ * Every further SHT4x in the devicetree adds an endpoint with its own
+ * set of measurement clusters.
  *
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdlib.h>
+
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/gpio.h>
-#include <zephyr/drivers/sensor.h>
 #include <zephyr/drivers/adc.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/reboot.h>
@@ -25,6 +28,15 @@
 #include <zb_nrf_platform.h>
 #include "zb_mem_config_custom.h"
 #include "zb_frostbee.h"
+#include "usb_console.h"
+#include "power_mode.h"
+#include "ota.h"
+#include "prod_config.h"
+#include "selftest.h"
+#include "sht4x_raw.h"
+#include "link_watch.h"
+#include "sleep_probe.h"
+#include "fleet_config.h"
 
 LOG_MODULE_REGISTER(frostbee, LOG_LEVEL_INF);
 
@@ -33,7 +45,62 @@ static void sensor_read_and_update(zb_bufid_t bufid);
 static void sensor_read_only(void);
 
 /* Sensor read interval in seconds (used for ZBOSS alarm scheduling). */
-#define SENSOR_READ_INTERVAL_S  10  /* 10s for dev, 600s for production */
+#define SENSOR_READ_INTERVAL_S  CONFIG_FROSTBEE_READ_INTERVAL_S
+
+/* Active read interval: SENSOR_READ_INTERVAL_S on batteries,
+ * CONFIG_FROSTBEE_MAINS_READ_INTERVAL_S when mains powered.
+ */
+static uint32_t sensor_read_interval_s = SENSOR_READ_INTERVAL_S;
+
+/* Interval overrides, 0 = not set: the provisioned battery interval
+ * (prod_config.h) and the configuration pushed over the air
+ * (fleet_config.h), which takes precedence.
+ */
+static uint16_t prod_read_interval_s;
+static struct fleet_config fleet_cfg;
+
+/* Continuous polling window for interview/configure (0 = off) */
+#define FAST_POLL_WINDOW_MS  (CONFIG_FROSTBEE_FAST_POLL_WINDOW_S * MSEC_PER_SEC)
+
+/* ─── Boot latency ─── */
+
+/* Milestones from reset to the device going back to sleep with its
+ * first values set.  Report delivery/acks happen inside the ZBOSS
+ * reporting engine and are not visible here; the first sleep after the
+ * first value marks the end of the boot-time active burst.
+ */
+enum boot_mark {
+	BOOT_MAIN,           /* main() entered */
+	BOOT_SENSOR_START,   /* first conversion started */
+	BOOT_ZIGBEE_ENABLE,  /* ZBOSS thread started */
+	BOOT_NETWORK,        /* network restored or joined */
+	BOOT_FIRST_VALUE,    /* first measurements in the ZCL attributes */
+	BOOT_FIRST_SLEEP,    /* ZBOSS allowed to sleep afterwards */
+	BOOT_MARK_COUNT,
+};
+
+static const char *const boot_mark_names[BOOT_MARK_COUNT] = {
+	"main", "sensor", "zigbee", "network", "value", "sleep",
+};
+
+static int64_t boot_ticks[BOOT_MARK_COUNT];
+static uint32_t boot_marked;
+
+static void boot_mark(enum boot_mark mark)
+{
+	if (boot_marked & BIT(mark)) {
+		return;
+	}
+	if (mark == BOOT_FIRST_SLEEP && !(boot_marked & BIT(BOOT_FIRST_VALUE))) {
+		return;
+	}
+
+	boot_ticks[mark] = k_uptime_ticks();
+	boot_marked |= BIT(mark);
+
+	LOG_INF("Boot: %-7s at %6u us", boot_mark_names[mark],
+		(uint32_t)k_ticks_to_us_floor64(boot_ticks[mark]));
+}
 
 /* Reset button timing (milliseconds) */
 #define BUTTON_DEBOUNCE_MS         100    /* Ignore edges within this window */
@@ -54,21 +121,22 @@ static void sensor_read_only(void);
 #define FROSTBEE_INIT_BASIC_STACK_VERSION  10
 #define FROSTBEE_INIT_BASIC_HW_VERSION     1
 #define FROSTBEE_INIT_BASIC_MANUF_NAME     "Frostbee"
+#if SHT4X_COUNT > 1
+#define FROSTBEE_INIT_BASIC_MODEL_ID       "FBE_TH_MZ"  /* multi-zone */
+#else
 #define FROSTBEE_INIT_BASIC_MODEL_ID       "FBE_TH_1"
+#endif
 #define FROSTBEE_INIT_BASIC_DATE_CODE      "20250201"
 #define FROSTBEE_INIT_BASIC_LOCATION_DESC  ""
 #define FROSTBEE_INIT_BASIC_PH_ENV         ZB_ZCL_BASIC_ENV_UNSPECIFIED
 
-/* Temperature measurement range: -40.00 C to +125.00 C (SHT40 spec) */
-#define FROSTBEE_TEMP_MIN_VALUE  (-4000)
-#define FROSTBEE_TEMP_MAX_VALUE  12500
-
-/* Humidity measurement range: 0.00% to 100.00% */
-#define FROSTBEE_HUM_MIN_VALUE   0
-#define FROSTBEE_HUM_MAX_VALUE   10000
-
 /* ─── Device context (ZCL attribute storage) ─── */
 
+/* Measurement attributes of one sensor (zone), one member per channel */
+struct zb_zone_ctx {
+	FROSTBEE_CHANNELS(FROSTBEE_CH_STORAGE, 0)
+};
+
 struct zb_device_ctx {
 	zb_zcl_basic_attrs_ext_t basic_attr;
 	zb_zcl_identify_attrs_t  identify_attr;
@@ -82,23 +150,12 @@ struct zb_device_ctx {
 	zb_uint8_t battery_alarm_mask;
 	zb_uint8_t battery_voltage_min_threshold;
 
-	/* Temperature measurement */
-	zb_int16_t  temp_measure_value;
-	zb_int16_t  temp_min_value;
-	zb_int16_t  temp_max_value;
-	zb_uint16_t temp_tolerance;
-
-	/* Humidity measurement */
-	zb_uint16_t hum_measure_value;
-	zb_uint16_t hum_min_value;
-	zb_uint16_t hum_max_value;
+	/* Index n (devicetree order) is zone n + 1 on FROSTBEE_ENDPOINT + n */
+	struct zb_zone_ctx zone[SHT4X_COUNT];
 };
 
 static struct zb_device_ctx dev_ctx;
 
-/* Sensor device handle */
-static const struct device *sht;
-
 /* ─── Battery voltage measurement ─── */
 
 /* ADC configuration for P0.29 (AIN5) */
@@ -111,6 +168,12 @@ static const struct device *sht;
 /* Voltage divider: R1=10kΩ, R2=10kΩ (divides by 2) */
 #define VDIV_FACTOR     2
 
+/* Below this the pack is considered absent (USB powered without batteries) */
+#define BATTERY_ABSENT_MV  2000
+
+/* ZCL "invalid" value for BatteryVoltage / BatteryPercentageRemaining */
+#define ZCL_BATTERY_INVALID  0xFF
+
 static const struct device *adc_dev;
 
 static struct adc_channel_cfg adc_cfg = {
@@ -123,6 +186,18 @@ static struct adc_channel_cfg adc_cfg = {
 
 static int16_t adc_sample_buffer;
 
+/* Samples per battery reading (trimmed mean from 3 samples up) */
+#define BATTERY_SAMPLES  CONFIG_FROSTBEE_BATTERY_SAMPLES
+
+/* SAADC offset calibration: on the first reading and whenever the SHT
+ * temperature has moved by more than the configured delta since the
+ * last calibration (the offset drifts with die temperature).
+ */
+#define ADC_CALIB_DELTA_CENTI  (CONFIG_FROSTBEE_ADC_CALIB_TEMP_DELTA * 100)
+
+static bool adc_calibrated;
+static int16_t adc_calib_temp;
+
 static struct adc_sequence adc_seq = {
 	.channels = BIT(ADC_CHANNEL_ID),
 	.buffer = &adc_sample_buffer,
@@ -158,6 +233,9 @@ static void do_factory_reset(zb_uint8_t param)
 	/* Note: zb_bdb_reset_via_local_action will trigger a reboot internally */
 }
 
+/* Defined with the sensor reads, needed by the short press */
+static void fast_poll_start(zb_uint8_t param);
+
 static void factory_reset_handler(struct k_work *work)
 {
 	ARG_UNUSED(work);
@@ -202,6 +280,8 @@ static void debounce_handler(struct k_work *work)
 			if (hold_time < BUTTON_SHORT_PRESS_MAX_MS) {
 				LOG_INF("Short press - forcing sensor read");
 				sensor_read_only();
+				/* Lets the coordinator reach the device now */
+				ZB_SCHEDULE_APP_CALLBACK(fast_poll_start, 0);
 			} else {
 				LOG_INF("Button released after %lld ms (no action)", hold_time);
 			}
@@ -247,6 +327,8 @@ static int button_init(void)
 
 	k_work_init_delayable(&debounce_work, debounce_handler);
 	k_work_init_delayable(&factory_reset_work, factory_reset_handler);
+	sleep_probe_watch_work("debounce_work", &debounce_work);
+	sleep_probe_watch_work("factory_reset_work", &factory_reset_work);
 
 	/* Initialize state from current pin level.
 	 * If button is pressed on boot (e.g., still held from factory reset),
@@ -352,18 +434,16 @@ zb_zcl_attr_t power_config_attr_list[] = {
 	}
 };
 
-ZB_ZCL_DECLARE_TEMP_MEASUREMENT_ATTRIB_LIST(
-	temp_measurement_attr_list,
-	&dev_ctx.temp_measure_value,
-	&dev_ctx.temp_min_value,
-	&dev_ctx.temp_max_value,
-	&dev_ctx.temp_tolerance);
+/* Channel attribute lists for every zone: zoneN_<channel>_attr_list */
+#define FROSTBEE_CH_ATTR_LIST_DECLARE(z, name, tag, value_attr, type, unknown, \
+				      min, max, has_tol, tol, report_cnt, \
+				      attr_list, ...)                           \
+	attr_list(FROSTBEE_CH_ATTR_LIST(z, name), dev_ctx.zone[z].name);
+
+#define FROSTBEE_ZONE_ATTR_LISTS(n, _) \
+	FROSTBEE_CHANNELS(FROSTBEE_CH_ATTR_LIST_DECLARE, n)
 
-ZB_ZCL_DECLARE_REL_HUMIDITY_MEASUREMENT_ATTRIB_LIST(
-	humidity_attr_list,
-	&dev_ctx.hum_measure_value,
-	&dev_ctx.hum_min_value,
-	&dev_ctx.hum_max_value);
+LISTIFY(SHT4X_COUNT, FROSTBEE_ZONE_ATTR_LISTS, ())
 
 /* ─── Cluster list, endpoint, device context ─── */
 
@@ -372,21 +452,58 @@ ZB_DECLARE_FROSTBEE_CLUSTER_LIST(
 	basic_attr_list,
 	identify_client_attr_list,
 	identify_server_attr_list,
-	power_config_attr_list,
-	temp_measurement_attr_list,
-	humidity_attr_list);
+	power_config_attr_list);
 
 ZB_DECLARE_FROSTBEE_EP(
 	frostbee_ep,
 	FROSTBEE_ENDPOINT,
 	frostbee_clusters);
 
-ZBOSS_DECLARE_DEVICE_CTX_1_EP(
+/* Zone endpoints for the second and further sensors (zone 1, index 0,
+ * lives on frostbee_ep)
+ */
+#define FROSTBEE_ZONE_EP_DECLARE(n, _)                               \
+	COND_CODE_0(n, (), (                                         \
+	ZB_DECLARE_FROSTBEE_ZONE_CLUSTER_LIST(zone_clusters_##n, n); \
+	ZB_DECLARE_FROSTBEE_ZONE_EP(                                 \
+		zone_ep_##n,                                         \
+		FROSTBEE_ENDPOINT + n,                               \
+		zone_clusters_##n);))
+
+#define FROSTBEE_ZONE_EP_REF(n, _) COND_CODE_0(n, (), (&zone_ep_##n,))
+
+LISTIFY(SHT4X_COUNT, FROSTBEE_ZONE_EP_DECLARE, ())
+
+#if defined(CONFIG_FROSTBEE_OTA)
+/* OTA Upgrade client endpoint is declared by the Zigbee FOTA library */
+extern zb_af_endpoint_desc_t zigbee_fota_client_ep;
+
+BUILD_ASSERT(FROSTBEE_ENDPOINT + SHT4X_COUNT <= CONFIG_ZIGBEE_FOTA_ENDPOINT,
+	     "zone endpoints overlap the OTA client endpoint");
+#endif
+
+zb_af_endpoint_desc_t *frostbee_ep_list[] = {
+#if defined(CONFIG_FROSTBEE_OTA)
+	&zigbee_fota_client_ep,
+#endif
+	&frostbee_ep,
+	LISTIFY(SHT4X_COUNT, FROSTBEE_ZONE_EP_REF, ())
+};
+
+ZBOSS_DECLARE_DEVICE_CTX(
 	frostbee_ctx,
-	frostbee_ep);
+	frostbee_ep_list,
+	ZB_ZCL_ARRAY_SIZE(frostbee_ep_list, zb_af_endpoint_desc_t *));
 
 /* ─── Attribute initialization ─── */
 
+#define FROSTBEE_CH_ATTR_INIT(z, name, tag, value_attr, type, unknown, \
+			      min, max, has_tol, tol, ...)        \
+	zone->name.measure_value = (unknown);                          \
+	zone->name.min_value = (min);                                  \
+	zone->name.max_value = (max);                                  \
+	IF_ENABLED(has_tol, (zone->name.tolerance = (tol);))
+
 static void clusters_attr_init(void)
 {
 	/* Basic cluster */
@@ -410,7 +527,10 @@ static void clusters_attr_init(void)
 		FROSTBEE_INIT_BASIC_DATE_CODE,
 		ZB_ZCL_STRING_CONST_SIZE(FROSTBEE_INIT_BASIC_DATE_CODE));
 
-	dev_ctx.basic_attr.power_source = ZB_ZCL_BASIC_POWER_SOURCE_BATTERY;
+	dev_ctx.basic_attr.power_source =
+		(power_mode_get() == POWER_MODE_MAINS) ?
+		ZB_ZCL_BASIC_POWER_SOURCE_DC_SOURCE :
+		ZB_ZCL_BASIC_POWER_SOURCE_BATTERY;
 
 	ZB_ZCL_SET_STRING_VAL(
 		dev_ctx.basic_attr.location_id,
@@ -432,20 +552,26 @@ static void clusters_attr_init(void)
 	dev_ctx.battery_alarm_mask = 0;
 	dev_ctx.battery_voltage_min_threshold = 30; /* 3.0V alarm threshold (1.0V per cell) */
 
-	/* Temperature measurement */
-	dev_ctx.temp_measure_value = ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_UNKNOWN;
-	dev_ctx.temp_min_value = FROSTBEE_TEMP_MIN_VALUE;
-	dev_ctx.temp_max_value = FROSTBEE_TEMP_MAX_VALUE;
-	dev_ctx.temp_tolerance = 20; /* 0.2 C tolerance (SHT40 typical accuracy) */
+	for (int i = 0; i < SHT4X_COUNT; i++) {
+		struct zb_zone_ctx *zone = &dev_ctx.zone[i];
 
-	/* Humidity measurement */
-	dev_ctx.hum_measure_value = ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_UNKNOWN;
-	dev_ctx.hum_min_value = FROSTBEE_HUM_MIN_VALUE;
-	dev_ctx.hum_max_value = FROSTBEE_HUM_MAX_VALUE;
+		FROSTBEE_CHANNELS(FROSTBEE_CH_ATTR_INIT, 0)
+	}
 }
 
 /* ─── Battery voltage measurement ─── */
 
+/* Request SAADC offset calibration with the next battery reading if the
+ * temperature (0.01 C) has drifted too far from the last calibration.
+ */
+static void adc_calib_check(int16_t temp)
+{
+	if (!adc_calibrated || abs(temp - adc_calib_temp) > ADC_CALIB_DELTA_CENTI) {
+		adc_seq.calibrate = true;
+		adc_calib_temp = temp;
+	}
+}
+
 /* Compare function for qsort - ascending order */
 static int compare_int16(const void *a, const void *b)
 {
@@ -460,15 +586,23 @@ static int compare_int16(const void *a, const void *b)
  * Power saving: P0.02 configured as INPUT (high-Z) when not measuring.
  *               Only set to OUTPUT LOW when reading ADC (enables divider).
  *
- * Measurement strategy: Take 5 samples, remove min/max, average middle 3.
- * This eliminates ADC noise and transient spikes.
+ * Measurement strategy: CONFIG_FROSTBEE_BATTERY_SAMPLES samples; from 3
+ * samples up min/max are dropped before averaging.  The SAADC offset is
+ * kept calibrated against temperature (adc_calib_check()), so one or two
+ * samples give the accuracy five trimmed samples used to.
+ *
+ * In mains mode a reading below BATTERY_ABSENT_MV means no pack is fitted;
+ * both battery attributes are then set to the ZCL invalid value (0xFF).
  *
  * Returns battery voltage in ZCL format (units of 100mV), or 0 on error.
  */
 static uint8_t read_battery_voltage(void)
 {
 	int ret;
-	int16_t samples[5];
+	int16_t samples[BATTERY_SAMPLES];
+	int32_t sum = 0;
+	int first = 0;
+	int count = BATTERY_SAMPLES;
 
 	if (!device_is_ready(adc_dev)) {
 		LOG_ERR("ADC device not ready");
@@ -487,8 +621,12 @@ static uint8_t read_battery_voltage(void)
 	 */
 	k_msleep(2);
 
-	/* Take 5 ADC samples */
-	for (int i = 0; i < 5; i++) {
+	/* First reading after boot calibrates even without a temperature */
+	if (!adc_calibrated) {
+		adc_seq.calibrate = true;
+	}
+
+	for (int i = 0; i < BATTERY_SAMPLES; i++) {
 		ret = adc_read(adc_dev, &adc_seq);
 		if (ret < 0) {
 			LOG_ERR("ADC read %d failed: %d", i, ret);
@@ -497,8 +635,15 @@ static uint8_t read_battery_voltage(void)
 		}
 		samples[i] = adc_sample_buffer;
 
+		if (adc_seq.calibrate) {
+			/* Offset calibration ran before this sample */
+			LOG_DBG("SAADC offset calibrated at %d cC", adc_calib_temp);
+			adc_seq.calibrate = false;
+			adc_calibrated = true;
+		}
+
 		/* Small delay between samples to allow ADC to settle */
-		if (i < 4) {
+		if (i < BATTERY_SAMPLES - 1) {
 			k_usleep(500);  /* 500µs between samples */
 		}
 	}
@@ -506,15 +651,19 @@ static uint8_t read_battery_voltage(void)
 	/* Disable voltage divider: set P0.02 as INPUT (high impedance, ~0µA) */
 	gpio_pin_configure_dt(&vbat_enable, GPIO_INPUT);
 
-	/* Sort samples to find min/max */
-	qsort(samples, 5, sizeof(int16_t), compare_int16);
+	/* From 3 samples up, drop min/max before averaging */
+	if (BATTERY_SAMPLES >= 3) {
+		qsort(samples, BATTERY_SAMPLES, sizeof(int16_t), compare_int16);
+		first = 1;
+		count = BATTERY_SAMPLES - 2;
+	}
 
-	/* Average the middle 3 values (exclude min=samples[0] and max=samples[4]) */
-	int32_t sum = samples[1] + samples[2] + samples[3];
-	int16_t avg_sample = sum / 3;
+	for (int i = first; i < first + count; i++) {
+		sum += samples[i];
+	}
+	int16_t avg_sample = sum / count;
 
-	LOG_DBG("ADC samples: [%d, %d, %d, %d, %d] → avg of middle 3: %d",
-		samples[0], samples[1], samples[2], samples[3], samples[4], avg_sample);
+	LOG_DBG("ADC: %d sample(s), avg of %d: %d", BATTERY_SAMPLES, count, avg_sample);
 
 	/* Convert ADC value to millivolts at ADC pin (P0.29)
 	 * Formula: mV = (sample × VREF_mV × GAIN_FACTOR) / (2^12 - 1)
@@ -525,6 +674,13 @@ static uint8_t read_battery_voltage(void)
 	/* Actual battery voltage (voltage divider is 1:2, so multiply by 2) */
 	int32_t battery_mv = adc_mv * VDIV_FACTOR;
 
+	if (power_mode_get() == POWER_MODE_MAINS && battery_mv < BATTERY_ABSENT_MV) {
+		LOG_DBG("Mains powered, no battery fitted (%d mV)", battery_mv);
+		dev_ctx.battery_voltage = ZCL_BATTERY_INVALID;
+		dev_ctx.battery_percentage = ZCL_BATTERY_INVALID;
+		return ZCL_BATTERY_INVALID;
+	}
+
 	/* Convert to ZCL format: units of 100mV */
 	uint8_t battery_zcl = (uint8_t)(battery_mv / 100);
 
@@ -554,69 +710,65 @@ static uint8_t read_battery_voltage(void)
 
 /* ─── Sensor reading & ZCL attribute update ─── */
 
+/* Log a channel value given in 0.01 units; zones are numbered from 1 */
+static void channel_log(int zone, const char *name, int32_t value)
+{
+	LOG_INF("Zone %d %s: %s%d.%02d (%d)", zone, name, value < 0 ? "-" : "",
+		abs(value) / 100, abs(value) % 100, value);
+}
+
+/* Scale one channel of a zone's sample and store it in its MeasuredValue.
+ * ZB_FALSE just stores the value; the ZBOSS reporting engine sends
+ * reports based on the coordinator's Configure Reporting thresholds
+ * (min/max interval, reportable change).
+ */
+#define FROSTBEE_CH_UPDATE(z, name, tag, value_attr, type, unknown,    \
+			   min, max, has_tol, tol, report_cnt, attr_list, \
+			   src, scale)                                 \
+	do {                                                           \
+		type value = scale(sample->src);                       \
+                                                                       \
+		channel_log(zone + 1, STRINGIFY(name), value);         \
+		ZB_ZCL_SET_ATTRIBUTE(                                  \
+			FROSTBEE_ENDPOINT + zone,                      \
+			ZB_ZCL_CLUSTER_ID_##tag,                       \
+			ZB_ZCL_CLUSTER_SERVER_ROLE,                    \
+			value_attr,                                    \
+			(zb_uint8_t *)&value,                          \
+			ZB_FALSE);                                     \
+	} while (0);
+
 /* Read sensor and update ZCL attributes (without rescheduling).
  * Used by button handler for on-demand reads.
  * Thread-safe via mutex - can be called from button or timer context.
  */
 static void sensor_read_only(void)
 {
-	struct sensor_value temp, hum;
-	int ret;
+	struct sht4x_sample samples[SHT4X_COUNT];
 
 	k_mutex_lock(&sensor_mutex, K_FOREVER);
 
-	if (!device_is_ready(sht)) {
-		LOG_ERR("SHT4X not ready, skipping read");
-		k_mutex_unlock(&sensor_mutex);
-		return;
-	}
+	/* All zones convert in parallel: one wait for the whole batch */
+	sht4x_raw_read_all(samples);
 
-	ret = sensor_sample_fetch(sht);
-	if (ret) {
-		LOG_ERR("Sensor fetch failed: %d", ret);
-		k_mutex_unlock(&sensor_mutex);
-		return;
+	if (samples[0].valid) {
+		adc_calib_check(SHT4X_TICKS_TO_TEMP(samples[0].t_ticks));
 	}
 
-	sensor_channel_get(sht, SENSOR_CHAN_AMBIENT_TEMP, &temp);
-	sensor_channel_get(sht, SENSOR_CHAN_HUMIDITY, &hum);
+	for (int zone = 0; zone < SHT4X_COUNT; zone++) {
+		const struct sht4x_sample *sample = &samples[zone];
 
-	/* Convert to ZCL format:
-	 * Temperature: signed int16 in units of 0.01 C
-	 * Humidity: unsigned int16 in units of 0.01 %RH
-	 */
-	zb_int16_t temp_zcl = (zb_int16_t)(temp.val1 * 100 +
-					    temp.val2 / 10000);
-	zb_uint16_t hum_zcl = (zb_uint16_t)(hum.val1 * 100 +
-					     hum.val2 / 10000);
-
-	LOG_INF("T: %d.%02d C (%d)  H: %d.%02d %%RH (%u)",
-		temp.val1, temp.val2 / 10000, temp_zcl,
-		hum.val1, hum.val2 / 10000, hum_zcl);
-
-	/* Update ZCL attributes — ZB_FALSE just stores the value.
-	 * The ZBOSS reporting engine sends reports automatically
-	 * based on the coordinator's Configure Reporting thresholds
-	 * (min/max interval, reportable change).
-	 */
-	ZB_ZCL_SET_ATTRIBUTE(
-		FROSTBEE_ENDPOINT,
-		ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-		ZB_ZCL_CLUSTER_SERVER_ROLE,
-		ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-		(zb_uint8_t *)&temp_zcl,
-		ZB_FALSE);
+		if (!sample->valid) {
+			/* Keep the last good value, nothing to report */
+			continue;
+		}
 
-	ZB_ZCL_SET_ATTRIBUTE(
-		FROSTBEE_ENDPOINT,
-		ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,
-		ZB_ZCL_CLUSTER_SERVER_ROLE,
-		ZB_ZCL_ATTR_REL_HUMIDITY_MEASUREMENT_VALUE_ID,
-		(zb_uint8_t *)&hum_zcl,
-		ZB_FALSE);
+		FROSTBEE_CHANNELS(FROSTBEE_CH_UPDATE, 0)
+	}
 
 	/* Read battery voltage via ADC */
 	read_battery_voltage();
+	ota_battery_update(dev_ctx.battery_percentage);
 
 	/* Update battery ZCL attributes */
 	ZB_ZCL_SET_ATTRIBUTE(
@@ -638,6 +790,39 @@ static void sensor_read_only(void)
 	k_mutex_unlock(&sensor_mutex);
 }
 
+/* Poll the parent continuously for FAST_POLL_WINDOW_MS (ZBOSS context).
+ * Pairing and reconfiguring then cost one short burst instead of one
+ * keepalive interval per request.
+ */
+static void fast_poll_start(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	if (FAST_POLL_WINDOW_MS == 0 || power_mode_get() != POWER_MODE_BATTERY ||
+	    !ZB_JOINED()) {
+		return;
+	}
+
+	LOG_INF("Fast poll for %u s", CONFIG_FROSTBEE_FAST_POLL_WINDOW_S);
+	zb_zdo_pim_start_turbo_poll_continuous(FAST_POLL_WINDOW_MS);
+}
+
+/* Pick the read interval for the power mode from the overrides */
+static void read_interval_update(void)
+{
+	if (power_mode_get() == POWER_MODE_MAINS) {
+		sensor_read_interval_s = fleet_cfg.mains_read_interval_s != 0 ?
+			fleet_cfg.mains_read_interval_s :
+			CONFIG_FROSTBEE_MAINS_READ_INTERVAL_S;
+	} else if (fleet_cfg.read_interval_s != 0) {
+		sensor_read_interval_s = fleet_cfg.read_interval_s;
+	} else if (prod_read_interval_s != 0) {
+		sensor_read_interval_s = prod_read_interval_s;
+	} else {
+		sensor_read_interval_s = SENSOR_READ_INTERVAL_S;
+	}
+}
+
 /* Periodic sensor read callback (called by Zigbee alarm scheduler).
  * Reads sensor and reschedules next read.
  */
@@ -646,11 +831,51 @@ static void sensor_read_and_update(zb_bufid_t bufid)
 	ARG_UNUSED(bufid);
 
 	sensor_read_only();
+	boot_mark(BOOT_FIRST_VALUE);
 
 	/* Schedule next periodic read */
 	ZB_SCHEDULE_APP_ALARM(sensor_read_and_update, 0,
 			      ZB_MILLISECONDS_TO_BEACON_INTERVAL(
-				      SENSOR_READ_INTERVAL_S * 1000));
+				      sensor_read_interval_s * 1000));
+}
+
+/* A configuration version was restored from NVRAM or committed over
+ * the air (ZBOSS context)
+ */
+static void fleet_config_applied(const struct fleet_config *cfg)
+{
+	fleet_cfg = *cfg;
+	read_interval_update();
+	LOG_INF("Sensor read interval %u s", sensor_read_interval_s);
+
+	/* Restart the read chain so the new interval applies now */
+	if (ZB_JOINED()) {
+		ZB_SCHEDULE_APP_ALARM_CANCEL(sensor_read_and_update,
+					     ZB_ALARM_ANY_PARAM);
+		ZB_SCHEDULE_APP_ALARM(sensor_read_and_update, 0,
+				      ZB_MILLISECONDS_TO_BEACON_INTERVAL(
+					      sensor_read_interval_s * 1000));
+	}
+}
+
+/* ─── ZCL device callback ─── */
+
+static void zcl_device_cb(zb_bufid_t bufid)
+{
+	zb_zcl_device_callback_param_t *device_cb_param =
+		ZB_BUF_GET_PARAM(bufid, zb_zcl_device_callback_param_t);
+
+	device_cb_param->status = RET_OK;
+
+	switch (device_cb_param->device_cb_id) {
+	case ZB_ZCL_OTA_UPGRADE_VALUE_CB_ID:
+		ota_zcl_cb(bufid);
+		break;
+
+	default:
+		device_cb_param->status = RET_NOT_IMPLEMENTED;
+		break;
+	}
 }
 
 /* ─── Zigbee signal handler ─── */
@@ -661,6 +886,21 @@ void zboss_signal_handler(zb_bufid_t bufid)
 	zb_zdo_app_signal_type_t sig = zb_get_app_signal(bufid, &sig_hndler);
 	zb_ret_t status = ZB_GET_APP_SIGNAL_STATUS(bufid);
 
+	if (sig == ZB_COMMON_SIGNAL_CAN_SLEEP) {
+		boot_mark(BOOT_FIRST_SLEEP);
+	}
+
+	/* OTA client tracks join state and server discovery on its own */
+	ota_signal_handler(bufid);
+
+	/* Re-parent when the link to the parent keeps failing; the
+	 * signals it handles must not start a second rejoin below
+	 */
+	if (link_watch_signal_handler(bufid)) {
+		zb_buf_free(bufid);
+		return;
+	}
+
 	switch (sig) {
 	case ZB_BDB_SIGNAL_DEVICE_REBOOT:
 		/* fall-through */
@@ -668,10 +908,19 @@ void zboss_signal_handler(zb_bufid_t bufid)
 		ZB_ERROR_CHECK(zigbee_default_signal_handler(bufid));
 		if (status == RET_OK) {
 			LOG_INF("Joined network, starting sensor reads");
-			/* Start periodic sensor reading */
-			ZB_SCHEDULE_APP_ALARM(sensor_read_and_update, 0,
-					      ZB_MILLISECONDS_TO_BEACON_INTERVAL(
-						      1000));
+			if (sig == ZB_BDB_SIGNAL_STEERING) {
+				/* New join: the coordinator interviews next */
+				fast_poll_start(0);
+			}
+			boot_mark(BOOT_NETWORK);
+			ota_confirm_image();
+			/* First read right away: the conversion started in
+			 * main() has finished while ZBOSS restored its state,
+			 * so the values are in before the first poll.
+			 */
+			ZB_SCHEDULE_APP_ALARM_CANCEL(sensor_read_and_update,
+						     ZB_ALARM_ANY_PARAM);
+			ZB_SCHEDULE_APP_CALLBACK(sensor_read_and_update, 0);
 		}
 		break;
 
@@ -687,10 +936,21 @@ void zboss_signal_handler(zb_bufid_t bufid)
 		ZB_ERROR_CHECK(zigbee_default_signal_handler(bufid));
 		break;
 
-	case ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY:
-		/* Production config partition is empty - this is normal,
-		 * we don't use install codes or pre-shared keys. */
+	case ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY: {
+		/* Raised before commissioning starts.  Provisioned units get
+		 * their install code/TX power from ZBOSS and a restricted
+		 * channel set and defaults from the application block.
+		 */
+		const struct frostbee_prod_cfg *cfg = prod_config_apply(bufid);
+
+		if (cfg != NULL && cfg->read_interval_s != 0) {
+			prod_read_interval_s = cfg->read_interval_s;
+			read_interval_update();
+			LOG_INF("Provisioned read interval %u s",
+				prod_read_interval_s);
+		}
 		break;
+	}
 
 	case ZB_SIGNAL_JOIN_DONE:
 		/* Certification testing signal - ignore. */
@@ -710,19 +970,20 @@ void zboss_signal_handler(zb_bufid_t bufid)
 
 int main(void)
 {
-	LOG_INF("Frostbee starting - Zigbee SHT40 sensor");
+	boot_mark(BOOT_MAIN);
 
-	/* Get sensor device handle */
-	sht = DEVICE_DT_GET_ANY(sensirion_sht4x);
-	if (sht == NULL) {
-		LOG_ERR("SHT4X device not found in devicetree");
-		return -ENODEV;
+	/* Console follows VBUS: full logs on the bench, none on batteries */
+	if (usb_console_init() < 0) {
+		LOG_WRN("USB console init failed - continuing without it");
 	}
-	if (!device_is_ready(sht)) {
-		LOG_ERR("SHT4X device not ready");
+
+	LOG_INF("Frostbee starting - Zigbee SHT40 sensor");
+
+	/* Sensors: every enabled sensirion,sht4x devicetree node */
+	if (sht4x_raw_init() < 0) {
+		LOG_ERR("SHT4X sensors not ready");
 		return -ENODEV;
 	}
-	LOG_INF("SHT40 sensor ready");
 
 	/* Initialize ADC for battery voltage measurement */
 	adc_dev = DEVICE_DT_GET(ADC_NODE);
@@ -754,13 +1015,44 @@ int main(void)
 #if DT_NODE_EXISTS(RESET_BUTTON_NODE)
 	if (button_init() < 0) {
 		LOG_WRN("Reset button init failed - continuing without it");
+	} else if (button_pressed_state && selftest_requested()) {
+		/* Held at power-up: manufacturing test, Zigbee stays off */
+		LOG_INF("Button held at power-up - entering self-test");
+		selftest_run();
 	}
 #endif
 
-	/* Configure as sleepy end device */
-	zb_set_ed_timeout(ED_AGING_TIMEOUT_64MIN);
-	zb_set_keepalive_timeout(ZB_MILLISECONDS_TO_BEACON_INTERVAL(3000));
-	zigbee_configure_sleepy_behavior(true);
+	/* Start the first conversion now; it runs while ZBOSS comes up and
+	 * is collected on network restore.  Not before the self-test check:
+	 * the SHT test must find the sensor idle.
+	 */
+	if (sht4x_raw_start() == 0) {
+		boot_mark(BOOT_SENSOR_START);
+	}
+
+	/* Battery: sleepy end device.  Mains: receiver always on, fast
+	 * sampling and (optionally) router role.
+	 */
+	if (power_mode_detect() == POWER_MODE_MAINS) {
+#if defined(CONFIG_FROSTBEE_ROUTER_ON_MAINS)
+		zb_set_network_router_role(CONFIG_ZIGBEE_CHANNEL_MASK);
+		LOG_INF("Mains powered - starting as router");
+#else
+		zb_set_ed_timeout(ED_AGING_TIMEOUT_64MIN);
+		zigbee_configure_sleepy_behavior(false);
+		LOG_INF("Mains powered - starting as rx-on end device");
+#endif
+	} else {
+#if defined(CONFIG_ZIGBEE_ROLE_ROUTER)
+		zb_set_network_ed_role(CONFIG_ZIGBEE_CHANNEL_MASK);
+#endif
+		zb_set_ed_timeout(ED_AGING_TIMEOUT_64MIN);
+		zb_set_keepalive_timeout(ZB_MILLISECONDS_TO_BEACON_INTERVAL(3000));
+		zigbee_configure_sleepy_behavior(true);
+		LOG_INF("Battery powered - starting as sleepy end device");
+	}
+
+	read_interval_update();
 
 	/* Power down unused RAM */
 	if (IS_ENABLED(CONFIG_RAM_POWER_DOWN_LIBRARY)) {
@@ -769,11 +1061,26 @@ int main(void)
 
 	/* Register device context and initialize attributes */
 	ZB_AF_REGISTER_DEVICE_CTX(&frostbee_ctx);
+	ZB_ZCL_REGISTER_DEVICE_CB(zcl_device_cb);
 	clusters_attr_init();
 
+	if (fleet_config_init(fleet_config_applied) < 0) {
+		LOG_WRN("Fleet config init failed - using build defaults");
+	}
+
+	if (ota_init() < 0) {
+		LOG_WRN("OTA client init failed - continuing without it");
+	}
+
 	/* Start Zigbee stack */
+	boot_mark(BOOT_ZIGBEE_ENABLE);
 	zigbee_enable();
 
+	/* Non-critical for the first report: after the stack is running */
+	if (sleep_probe_init() < 0) {
+		LOG_WRN("Sleep probe init failed");
+	}
+
 	LOG_INF("Frostbee Zigbee stack started");
 
 	while (1) {
@@ -0,0 +1,449 @@
+/*
+ * Frostbee - Zigbee OTA Upgrade client pacing
+ *
+ * Server discovery, image download and the MCUboot secondary slot are
+ * handled by the nRF Connect SDK Zigbee FOTA library.  This module sits
+ * between ZBOSS and that library and decides how fast blocks may be
+ * fetched:
+ *
+ *   - Never start a download on low cells (battery mode only).
+ *   - Fetch at most CONFIG_FROSTBEE_OTA_BLOCKS_PER_WAKE blocks, then hold
+ *     the client (ZB_ZCL_OTA_UPGRADE_STATUS_BUSY) until the next wake,
+ *     so block exchanges ride along with the regular poll schedule.
+ *   - Cap the bytes fetched per hour, which bounds the energy an update
+ *     may take from the pack.
+ *
+ * A hold is decided before a block reaches the library: the held block
+ * is not consumed and the client requests it again on resume.
+ *
+ * Downloads survive a reboot.  The DFU stream saves its own progress
+ * (CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS); this module only stores
+ * which image is being fetched and where the MCUboot image starts in
+ * the OTA file.  When the same image is offered again, START is not
+ * passed to the library (it would reset the DFU target and expect the
+ * OTA header at offset 0): the client's FileOffset is set to the
+ * stream's saved offset and this module writes the remaining blocks to
+ * the DFU target itself, up to the image check and the MCUboot swap.
+ * Like the library, it expects the upgrade image as the first
+ * sub-element.
+ *
+ * Mains-powered units download at full speed.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/reboot.h>
+#include <zephyr/dfu/mcuboot.h>
+#include <dfu/dfu_target.h>
+#include <dfu/dfu_target_mcuboot.h>
+
+#include <zboss_api.h>
+#include <zigbee/zigbee_error_handler.h>
+
+#include "ota.h"
+#include "power_mode.h"
+
+LOG_MODULE_REGISTER(ota, LOG_LEVEL_INF);
+
+#define OTA_HOUR_MS        (60 * 60 * 1000)
+
+/* OTA file layout (ZCL spec 11.4): header length at offset 6, then one
+ * sub-element header (tag, 32-bit length) before the MCUboot image
+ */
+#define OTA_HDR_LEN_OFFSET   6
+#define OTA_SUBELEM_HDR_LEN  6
+
+/* Image being downloaded, kept across reboots.  The progress itself is
+ * the DFU stream's saved offset, never stored here.
+ */
+struct ota_image {
+	zb_uint32_t file_version;
+	zb_uint32_t file_length;
+	zb_uint32_t image_start;  /* file offset of the MCUboot image */
+	zb_uint32_t image_size;
+};
+
+static struct ota_image image;
+
+/* Download continued by this module after a reboot; the DFU stream
+ * saves its progress each time this buffer is flushed to flash
+ */
+static bool resumed;
+static uint8_t dfu_buf[512] __aligned(4);
+
+/* Pacing counters */
+static zb_uint8_t blocks_this_wake;
+static int64_t hour_window_start;
+static zb_uint32_t hour_window_bytes;
+static bool client_held;
+
+/* Last known battery level; 0xFF until the first measurement */
+static zb_uint8_t battery_level = 0xFF;
+
+static int ota_settings_set(const char *name, size_t len,
+			    settings_read_cb read_cb, void *cb_arg)
+{
+	if (strcmp(name, "image") != 0 || len != sizeof(image)) {
+		return -ENOENT;
+	}
+
+	if (read_cb(cb_arg, &image, sizeof(image)) != sizeof(image)) {
+		memset(&image, 0, sizeof(image));
+		return -EIO;
+	}
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(ota, "ota", NULL, ota_settings_set, NULL, NULL);
+
+static void ota_image_clear(void)
+{
+	memset(&image, 0, sizeof(image));
+	(void)settings_delete("ota/image");
+}
+
+/* First block of a download the library handles: note where the
+ * MCUboot image sits so a reboot can resume into the same DFU stream
+ */
+static void ota_image_record(const zb_zcl_ota_upgrade_value_param_t *value)
+{
+	const zb_uint8_t *data = value->upgrade.receive.block_data;
+	zb_uint16_t len = value->upgrade.receive.data_length;
+	zb_uint16_t hdr_len;
+	int ret;
+
+	if (len < OTA_HDR_LEN_OFFSET + 2) {
+		return;
+	}
+	hdr_len = sys_get_le16(&data[OTA_HDR_LEN_OFFSET]);
+	if (len < hdr_len + OTA_SUBELEM_HDR_LEN) {
+		LOG_WRN("OTA header spans blocks, download cannot resume");
+		return;
+	}
+
+	image.image_start = hdr_len + OTA_SUBELEM_HDR_LEN;
+	image.image_size = sys_get_le32(&data[hdr_len + 2]);
+
+	ret = settings_save_one("ota/image", &image, sizeof(image));
+	if (ret) {
+		LOG_WRN("Failed to save OTA image info: %d", ret);
+	}
+}
+
+static void dfu_evt_handler(enum dfu_target_evt_id evt)
+{
+	ARG_UNUSED(evt);
+}
+
+/* Open the MCUboot DFU target for the recorded image and return the
+ * offset its stream saved, or 0 if there is nothing to resume
+ */
+static size_t dfu_saved_offset(void)
+{
+	size_t offset = 0;
+
+	if (dfu_target_mcuboot_set_buf(dfu_buf, sizeof(dfu_buf)) ||
+	    dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, 0, image.image_size,
+			    dfu_evt_handler)) {
+		return 0;
+	}
+
+	if (dfu_target_offset_get(&offset) || offset >= image.image_size) {
+		(void)dfu_target_done(false);
+		return 0;
+	}
+	return offset;
+}
+
+static void resumed_abort(void)
+{
+	LOG_ERR("Resumed OTA download failed");
+	resumed = false;
+	(void)dfu_target_reset();
+	ota_image_clear();
+}
+
+static bool battery_ok(void)
+{
+	if (power_mode_get() == POWER_MODE_MAINS) {
+		return true;
+	}
+
+	/* 0xFF: not measured yet (or invalid) - do not risk it */
+	return battery_level != 0xFF &&
+	       battery_level >= CONFIG_FROSTBEE_OTA_MIN_BATTERY_PCT * 2;
+}
+
+static void ota_resume(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	client_held = false;
+	blocks_this_wake = 0;
+	zb_zcl_ota_upgrade_resume_client(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+					 ZB_ZCL_OTA_UPGRADE_STATUS_OK);
+}
+
+/* Returns how long (ms) to hold the client before the next block,
+ * or 0 if it may be fetched now.
+ */
+static uint32_t ota_hold_ms(void)
+{
+	int64_t now = k_uptime_get();
+
+	if (power_mode_get() == POWER_MODE_MAINS) {
+		return 0;
+	}
+
+	if (now - hour_window_start >= OTA_HOUR_MS) {
+		hour_window_start = now;
+		hour_window_bytes = 0;
+	}
+
+	if (hour_window_bytes >= CONFIG_FROSTBEE_OTA_MAX_KB_PER_HOUR * 1024) {
+		LOG_INF("OTA hourly budget used, pausing");
+		return (uint32_t)(hour_window_start + OTA_HOUR_MS - now);
+	}
+
+	if (blocks_this_wake >= CONFIG_FROSTBEE_OTA_BLOCKS_PER_WAKE) {
+		return CONFIG_FROSTBEE_OTA_WAKE_INTERVAL_MS;
+	}
+
+	return 0;
+}
+
+static void ota_on_start(zb_zcl_ota_upgrade_value_param_t *value)
+{
+	zb_uint32_t version = value->upgrade.start.file_version;
+	zb_uint32_t length = value->upgrade.start.file_length;
+
+	if (!battery_ok()) {
+		LOG_WRN("OTA image 0x%08x offered, battery too low - declining",
+			version);
+		value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
+		return;
+	}
+
+	hour_window_start = k_uptime_get();
+	hour_window_bytes = 0;
+	blocks_this_wake = 0;
+	resumed = false;
+
+	if (image.file_version == version && image.file_length == length &&
+	    image.image_size != 0) {
+		size_t offset = dfu_saved_offset();
+
+		if (offset > 0) {
+			zb_uint32_t file_offset = image.image_start + offset;
+
+			LOG_INF("Resuming OTA image 0x%08x at %u/%u",
+				version, file_offset, length);
+			ZB_ZCL_SET_ATTRIBUTE(
+				CONFIG_ZIGBEE_FOTA_ENDPOINT,
+				ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+				ZB_ZCL_CLUSTER_CLIENT_ROLE,
+				ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID,
+				(zb_uint8_t *)&file_offset,
+				ZB_FALSE);
+			resumed = true;
+			value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_OK;
+			return;
+		}
+	}
+
+	LOG_INF("Starting OTA image 0x%08x (%u bytes)", version, length);
+	image.file_version = version;
+	image.file_length = length;
+	image.image_start = 0;
+	image.image_size = 0;
+}
+
+/* Blocks and end of a resumed download, which the library never saw */
+static void resumed_zcl_cb(zb_zcl_ota_upgrade_value_param_t *value)
+{
+	switch (value->upgrade_status) {
+	case ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE: {
+		zb_uint32_t offset = value->upgrade.receive.file_offset;
+		zb_uint32_t end = image.image_start + image.image_size;
+		const zb_uint8_t *data = value->upgrade.receive.block_data;
+		zb_uint32_t len = value->upgrade.receive.data_length;
+
+		value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_OK;
+
+		/* Only the image goes to flash, not what follows it */
+		if (offset < image.image_start || offset >= end) {
+			break;
+		}
+		len = MIN(len, end - offset);
+		if (dfu_target_write(data, len)) {
+			resumed_abort();
+			value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
+		}
+		break;
+	}
+
+	case ZB_ZCL_OTA_UPGRADE_STATUS_CHECK:
+		if (dfu_target_done(true)) {
+			resumed_abort();
+			value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_ERROR;
+			break;
+		}
+		value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_OK;
+		break;
+
+	case ZB_ZCL_OTA_UPGRADE_STATUS_APPLY:
+		value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_OK;
+		break;
+
+	case ZB_ZCL_OTA_UPGRADE_STATUS_FINISH:
+		if (dfu_target_schedule_update(0)) {
+			resumed_abort();
+			break;
+		}
+		LOG_INF("OTA image downloaded, rebooting into MCUboot");
+		ota_image_clear();
+		sys_reboot(SYS_REBOOT_COLD);
+		break;
+
+	case ZB_ZCL_OTA_UPGRADE_STATUS_ABORT:
+		resumed_abort();
+		value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_OK;
+		break;
+
+	default:
+		value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_OK;
+		break;
+	}
+}
+
+void ota_zcl_cb(zb_bufid_t bufid)
+{
+	zb_zcl_device_callback_param_t *device_cb_param =
+		ZB_BUF_GET_PARAM(bufid, zb_zcl_device_callback_param_t);
+	zb_zcl_ota_upgrade_value_param_t *value =
+		&device_cb_param->cb_param.ota_value_param;
+
+	if (value->upgrade_status == ZB_ZCL_OTA_UPGRADE_STATUS_START) {
+		ota_on_start(value);
+		/* Declined, or resumed: the library must not reset the target */
+		if (value->upgrade_status != ZB_ZCL_OTA_UPGRADE_STATUS_START) {
+			device_cb_param->status = RET_OK;
+			return;
+		}
+	}
+
+	if (value->upgrade_status == ZB_ZCL_OTA_UPGRADE_STATUS_RECEIVE) {
+		zb_uint16_t len = value->upgrade.receive.data_length;
+		uint32_t delay_ms = client_held ? 0 : ota_hold_ms();
+
+		/* Hold before the library sees the block, so it is fetched
+		 * again on resume rather than lost.
+		 */
+		if (client_held || delay_ms > 0) {
+			value->upgrade_status = ZB_ZCL_OTA_UPGRADE_STATUS_BUSY;
+			device_cb_param->status = RET_OK;
+			if (!client_held) {
+				client_held = true;
+				ZB_ERROR_CHECK(ZB_SCHEDULE_APP_ALARM(
+					ota_resume, 0,
+					ZB_MILLISECONDS_TO_BEACON_INTERVAL(delay_ms)));
+			}
+			return;
+		}
+
+		if (resumed) {
+			resumed_zcl_cb(value);
+			device_cb_param->status = RET_OK;
+		} else {
+			if (value->upgrade.receive.file_offset == 0) {
+				ota_image_record(value);
+			}
+			zigbee_fota_zcl_cb(bufid);
+		}
+		if (value->upgrade_status == ZB_ZCL_OTA_UPGRADE_STATUS_OK) {
+			hour_window_bytes += len;
+			blocks_this_wake++;
+		}
+		return;
+	}
+
+	if (resumed) {
+		resumed_zcl_cb(value);
+		device_cb_param->status = RET_OK;
+		return;
+	}
+
+	zigbee_fota_zcl_cb(bufid);
+}
+
+static void ota_evt_handler(const struct zigbee_fota_evt *evt)
+{
+	switch (evt->id) {
+	case ZIGBEE_FOTA_EVT_PROGRESS:
+		LOG_INF("OTA progress: %d%%", evt->dl.progress);
+		break;
+
+	case ZIGBEE_FOTA_EVT_FINISHED:
+		LOG_INF("OTA image downloaded, rebooting into MCUboot");
+		ota_image_clear();
+		sys_reboot(SYS_REBOOT_COLD);
+		break;
+
+	case ZIGBEE_FOTA_EVT_ERROR:
+		/* A broken image must not be resumed on the next attempt */
+		LOG_ERR("OTA download failed");
+		ota_image_clear();
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ota_signal_handler(zb_bufid_t bufid)
+{
+	zigbee_fota_signal_handler(bufid);
+}
+
+void ota_confirm_image(void)
+{
+	if (!boot_is_img_confirmed()) {
+		int ret = boot_write_img_confirmed();
+
+		if (ret) {
+			LOG_ERR("Couldn't confirm image: %d", ret);
+		} else {
+			LOG_INF("Marked image as OK");
+		}
+	}
+}
+
+void ota_battery_update(zb_uint8_t battery_percentage)
+{
+	battery_level = battery_percentage;
+}
+
+int ota_init(void)
+{
+	int ret;
+
+	ret = settings_subsys_init();
+	if (ret) {
+		LOG_ERR("Settings init failed: %d", ret);
+		return ret;
+	}
+	settings_load_subtree("ota");
+
+	if (image.image_size != 0) {
+		LOG_INF("Pending OTA image 0x%08x, resumes when offered again",
+			image.file_version);
+	}
+
+	return zigbee_fota_init(ota_evt_handler);
+}
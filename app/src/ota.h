@@ -0,0 +1,59 @@
+/*
+ * Frostbee - Zigbee OTA Upgrade client pacing
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef OTA_H
+#define OTA_H 1
+
+#include <zboss_api.h>
+
+#if defined(CONFIG_FROSTBEE_OTA)
+
+#include <zigbee/zigbee_fota.h>
+
+/** @brief Initialize the OTA client; call before zigbee_enable(). */
+int ota_init(void);
+
+/** @brief Forward ZBOSS signals to the OTA client. */
+void ota_signal_handler(zb_bufid_t bufid);
+
+/** @brief Handle ZB_ZCL_OTA_UPGRADE_VALUE_CB_ID from the ZCL device callback. */
+void ota_zcl_cb(zb_bufid_t bufid);
+
+/** @brief Mark the running MCUboot image as good once the network is up. */
+void ota_confirm_image(void);
+
+/** @brief Latest BatteryPercentageRemaining (ZCL 0.5% units). */
+void ota_battery_update(zb_uint8_t battery_percentage);
+
+#else
+
+static inline int ota_init(void)
+{
+	return 0;
+}
+
+static inline void ota_signal_handler(zb_bufid_t bufid)
+{
+	ARG_UNUSED(bufid);
+}
+
+static inline void ota_zcl_cb(zb_bufid_t bufid)
+{
+	ARG_UNUSED(bufid);
+}
+
+static inline void ota_confirm_image(void)
+{
+}
+
+static inline void ota_battery_update(zb_uint8_t battery_percentage)
+{
+	ARG_UNUSED(battery_percentage);
+}
+
+#endif /* CONFIG_FROSTBEE_OTA */
+
+#endif /* OTA_H */
@@ -0,0 +1,40 @@
+/*
+ * Frostbee - Power source detection
+ *
+ * The mode is decided once at boot: switching between sleepy and
+ * always-on behaviour (or between end device and router) is only safe
+ * before the Zigbee stack is started.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <hal/nrf_power.h>
+
+#include "power_mode.h"
+
+static enum power_mode mode = POWER_MODE_BATTERY;
+
+bool power_vbus_present(void)
+{
+	return nrf_power_usbregstatus_vbusdet_get(NRF_POWER);
+}
+
+enum power_mode power_mode_detect(void)
+{
+	if (IS_ENABLED(CONFIG_FROSTBEE_POWER_MODE_MAINS)) {
+		mode = POWER_MODE_MAINS;
+	} else if (IS_ENABLED(CONFIG_FROSTBEE_POWER_MODE_AUTO) &&
+		   power_vbus_present()) {
+		mode = POWER_MODE_MAINS;
+	} else {
+		mode = POWER_MODE_BATTERY;
+	}
+
+	return mode;
+}
+
+enum power_mode power_mode_get(void)
+{
+	return mode;
+}
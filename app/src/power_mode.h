@@ -0,0 +1,26 @@
+/*
+ * Frostbee - Power source detection
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef POWER_MODE_H
+#define POWER_MODE_H 1
+
+#include <stdbool.h>
+
+enum power_mode {
+	POWER_MODE_BATTERY,  /* Sleepy end device, long sensor interval */
+	POWER_MODE_MAINS,    /* USB/mains: rx-on-when-idle, fast sampling */
+};
+
+/** @brief Decide the power mode; called once at boot before Zigbee starts. */
+enum power_mode power_mode_detect(void);
+
+/** @brief Power mode chosen at boot. */
+enum power_mode power_mode_get(void);
+
+/** @brief Whether VBUS is currently present. */
+bool power_vbus_present(void);
+
+#endif /* POWER_MODE_H */
@@ -0,0 +1,91 @@
+/*
+ * Frostbee - Production configuration (zboss_product_config partition)
+ *
+ * ZBOSS reads the zboss_product_config partition on start-up, applies the
+ * standard fields and hands the application block to us through
+ * ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY.  Restricting steering to a single
+ * primary channel (and no secondary scan) is what keeps commissioning
+ * radio time short; scanning all 16 channels costs several seconds of
+ * receiver-on time per attempt.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+#include <zboss_api.h>
+
+#include "prod_config.h"
+
+LOG_MODULE_REGISTER(prod_config, LOG_LEVEL_INF);
+
+/* IEEE 802.15.4 channels 11-26 */
+#define ZB_CHANNEL_MASK_ALL  0x07FFF800U
+
+static struct frostbee_prod_cfg prod_cfg;
+
+static bool ext_pan_id_is_set(const uint8_t *ext_pan_id)
+{
+	for (int i = 0; i < 8; i++) {
+		if (ext_pan_id[i] != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const struct frostbee_prod_cfg *prod_config_apply(zb_bufid_t bufid)
+{
+	zb_zdo_app_signal_hdr_t *sig_hndler = NULL;
+	zb_ret_t status = ZB_GET_APP_SIGNAL_STATUS(bufid);
+	size_t len;
+
+	(void)zb_get_app_signal(bufid, &sig_hndler);
+
+	if (status != RET_OK) {
+		/* Empty partition - unprovisioned unit, open steering */
+		LOG_INF("No production config, using build defaults");
+		return NULL;
+	}
+
+	len = zb_buf_len(bufid) - sizeof(zb_zdo_app_signal_hdr_t);
+	if (len < sizeof(prod_cfg)) {
+		LOG_WRN("Production config without application block (%zu bytes)",
+			len);
+		return NULL;
+	}
+
+	memcpy(&prod_cfg, ZB_ZDO_SIGNAL_GET_PARAMS(sig_hndler, zb_uint8_t),
+	       sizeof(prod_cfg));
+
+	if (prod_cfg.version != FROSTBEE_PROD_CFG_VERSION) {
+		LOG_WRN("Unsupported production config version %u",
+			prod_cfg.version);
+		return NULL;
+	}
+
+	prod_cfg.channel_mask = sys_le32_to_cpu(prod_cfg.channel_mask);
+	prod_cfg.read_interval_s = sys_le16_to_cpu(prod_cfg.read_interval_s);
+	prod_cfg.channel_mask &= ZB_CHANNEL_MASK_ALL;
+
+	if (prod_cfg.channel_mask != 0) {
+		zb_set_bdb_primary_channel_set(prod_cfg.channel_mask);
+		zb_set_bdb_secondary_channel_set(0);
+		LOG_INF("Provisioned channel mask 0x%08x", prod_cfg.channel_mask);
+	}
+
+	if (ext_pan_id_is_set(prod_cfg.ext_pan_id)) {
+		zb_set_use_extended_pan_id(prod_cfg.ext_pan_id);
+		LOG_INF("Provisioned network %02x%02x%02x%02x%02x%02x%02x%02x",
+			prod_cfg.ext_pan_id[7], prod_cfg.ext_pan_id[6],
+			prod_cfg.ext_pan_id[5], prod_cfg.ext_pan_id[4],
+			prod_cfg.ext_pan_id[3], prod_cfg.ext_pan_id[2],
+			prod_cfg.ext_pan_id[1], prod_cfg.ext_pan_id[0]);
+	}
+
+	return &prod_cfg;
+}
@@ -0,0 +1,38 @@
+/*
+ * Frostbee - Production configuration (zboss_product_config partition)
+ *
+ * The partition holds the standard ZBOSS production config (IEEE address,
+ * install code, channel mask, TX power), which the stack applies itself,
+ * followed by the application block below.  The block is written by
+ * tools/provision/frostbee_provision.py; keep both in sync.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PROD_CONFIG_H
+#define PROD_CONFIG_H 1
+
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+#include <zboss_api.h>
+
+#define FROSTBEE_PROD_CFG_VERSION  1
+
+/** @brief Application part of the production config (little endian). */
+struct frostbee_prod_cfg {
+	uint8_t  version;          /* FROSTBEE_PROD_CFG_VERSION */
+	uint8_t  reserved;
+	uint16_t read_interval_s;  /* Battery-mode sensor interval, 0 = default */
+	uint32_t channel_mask;     /* Steering channels, 0 = build default */
+	uint8_t  ext_pan_id[8];    /* Network to join, all zero = any */
+} __packed;
+
+/** @brief Parse and apply ZB_ZDO_SIGNAL_PRODUCTION_CONFIG_READY.
+ *
+ * Restricts steering to the provisioned channels and network.
+ *
+ * @return Provisioned config, or NULL if the partition is empty/invalid.
+ */
+const struct frostbee_prod_cfg *prod_config_apply(zb_bufid_t bufid);
+
+#endif /* PROD_CONFIG_H */
@@ -0,0 +1,373 @@
+/*
+ * Frostbee - Manufacturing self-test
+ *
+ * Entered by holding the button while powering the unit up.  Checks
+ * every SHT4x zone (serial number, measurement, CRC), the battery ADC
+ * and divider switch, the LED pin and the radio (energy detect on every
+ * channel), then prints a single line on the USB CDC console, with one
+ * "sht" entry per zone:
+ *
+ *   SELFTEST {"v":2,"pass":1,"ms":37,"id":"...","sht":[{...},...],...}
+ *
+ * The line is repeated whenever the host (re)asserts DTR, so a fixture
+ * script can open the port at any time.  tools/selftest/ drives many
+ * dongles in parallel.  The Zigbee stack is never started in this mode.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/hwinfo.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/drivers/clock_control.h>
+#include <zephyr/drivers/clock_control/nrf_clock_control.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/printk.h>
+#include <hal/nrf_radio.h>
+
+#include "selftest.h"
+#include "sht4x_raw.h"
+
+#define SELFTEST_FORMAT_VERSION  2
+
+/* SHT4x commands (datasheet section 4.5) */
+#define SHT4X_CMD_MEASURE_HIGH   0xFD
+#define SHT4X_CMD_READ_SERIAL    0x89
+#define SHT4X_MEASURE_WAIT_MS    10
+#define SHT4X_CRC_POLY           0x31
+#define SHT4X_CRC_INIT           0xFF
+
+/* Plausible ambient range in the fixture */
+#define SELFTEST_TEMP_MIN        (-1000)  /* -10.00 C */
+#define SELFTEST_TEMP_MAX        6000     /*  60.00 C */
+
+/* Battery/fixture supply window at the divider, in mV */
+#define SELFTEST_VBAT_MIN_MV     2800
+#define SELFTEST_VBAT_MAX_MV     4800
+/* Divider off must read at least this much higher than divider on */
+#define SELFTEST_DIV_DELTA_MV    300
+
+/* ED_RSSIOFFS / ED_RSSISCALE from the nRF52840 product specification */
+#define RADIO_ED_RSSIOFFS        (-92)
+#define RADIO_ED_RSSISCALE       4
+#define RADIO_EVENT_TIMEOUT_US   1000
+
+/* Same ADC setup as main.c (AIN5, gain 1/6, 0.6 V reference, 12 bit) */
+#define ADC_CHANNEL_ID           5
+#define ADC_FULL_SCALE_MV        (600 * 6)
+
+#define SHT_I2C(node_id)  I2C_DT_SPEC_GET(node_id),
+
+/* Every zone, in the same order as sht4x_raw.c */
+static const struct i2c_dt_spec sht_i2c[SHT4X_COUNT] = {
+	DT_FOREACH_STATUS_OKAY(sensirion_sht4x, SHT_I2C)
+};
+static const struct gpio_dt_spec vbat_en = GPIO_DT_SPEC_GET(DT_NODELABEL(vbat_en), gpios);
+static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
+static const struct device *const adc_dev = DEVICE_DT_GET(DT_NODELABEL(adc));
+static const struct device *const console = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+
+struct sht_result {
+	bool ok;
+	uint32_t serial;
+	int16_t temp;
+	uint16_t hum;
+};
+
+struct selftest_result {
+	bool sht_ok;  /* all zones */
+	struct sht_result sht[SHT4X_COUNT];
+
+	bool adc_ok;
+	int32_t vbat_mv;
+	int32_t open_mv;
+
+	bool led_ok;
+
+	bool radio_ok;
+	int8_t ed_max_dbm;
+	uint8_t ed_max_channel;
+
+	uint32_t elapsed_ms;
+};
+
+static struct selftest_result result;
+
+bool selftest_requested(void)
+{
+	uint32_t cause = 0;
+
+	(void)hwinfo_get_reset_cause(&cause);
+	(void)hwinfo_clear_reset_cause();
+
+	return !(cause & RESET_SOFTWARE);
+}
+
+/* Read one or two CRC-protected 16-bit words */
+static int sht_read_words(const struct i2c_dt_spec *i2c, uint8_t cmd,
+			  uint32_t wait_ms, uint16_t *words)
+{
+	uint8_t rx[6];
+	int ret;
+
+	ret = i2c_write_dt(i2c, &cmd, 1);
+	if (ret < 0) {
+		return ret;
+	}
+
+	k_msleep(wait_ms);
+
+	ret = i2c_read_dt(i2c, rx, sizeof(rx));
+	if (ret < 0) {
+		return ret;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		const uint8_t *w = &rx[i * 3];
+
+		if (crc8(w, 2, SHT4X_CRC_POLY, SHT4X_CRC_INIT, false) != w[2]) {
+			return -EILSEQ;
+		}
+		words[i] = sys_get_be16(w);
+	}
+
+	return 0;
+}
+
+static void test_sht_zone(const struct i2c_dt_spec *i2c, struct sht_result *sht)
+{
+	uint16_t words[2];
+
+	if (!i2c_is_ready_dt(i2c)) {
+		return;
+	}
+
+	if (sht_read_words(i2c, SHT4X_CMD_READ_SERIAL, 1, words) < 0) {
+		return;
+	}
+	sht->serial = ((uint32_t)words[0] << 16) | words[1];
+
+	if (sht_read_words(i2c, SHT4X_CMD_MEASURE_HIGH, SHT4X_MEASURE_WAIT_MS,
+			   words) < 0) {
+		return;
+	}
+
+	/* T = -45 + 175 * ticks / 65535, RH = -6 + 125 * ticks / 65535 */
+	sht->temp = (int16_t)(-4500 + (17500 * (int32_t)words[0]) / 65535);
+	sht->hum = (uint16_t)CLAMP(-600 + (12500 * (int32_t)words[1]) / 65535,
+				   0, 10000);
+
+	sht->ok = sht->serial != 0 &&
+		  sht->temp >= SELFTEST_TEMP_MIN &&
+		  sht->temp <= SELFTEST_TEMP_MAX;
+}
+
+static void test_sht(void)
+{
+	result.sht_ok = true;
+	for (int i = 0; i < SHT4X_COUNT; i++) {
+		test_sht_zone(&sht_i2c[i], &result.sht[i]);
+		result.sht_ok = result.sht_ok && result.sht[i].ok;
+	}
+}
+
+static int adc_read_mv(int32_t *mv)
+{
+	int16_t sample;
+	struct adc_sequence seq = {
+		.channels = BIT(ADC_CHANNEL_ID),
+		.buffer = &sample,
+		.buffer_size = sizeof(sample),
+		.resolution = 12,
+	};
+	int ret = adc_read(adc_dev, &seq);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	*mv = ((int32_t)sample * ADC_FULL_SCALE_MV) / 4095;
+	return 0;
+}
+
+static void test_adc(void)
+{
+	int32_t on_mv;
+
+	/* Divider off: AIN5 is pulled to BAT+ through R1 (clips at 3.6 V) */
+	gpio_pin_configure_dt(&vbat_en, GPIO_INPUT);
+	k_msleep(2);
+	if (adc_read_mv(&result.open_mv) < 0) {
+		return;
+	}
+
+	gpio_pin_configure_dt(&vbat_en, GPIO_OUTPUT_ACTIVE);
+	k_msleep(2);
+	if (adc_read_mv(&on_mv) < 0) {
+		gpio_pin_configure_dt(&vbat_en, GPIO_INPUT);
+		return;
+	}
+	gpio_pin_configure_dt(&vbat_en, GPIO_INPUT);
+
+	result.vbat_mv = on_mv * 2;
+	result.adc_ok = result.vbat_mv >= SELFTEST_VBAT_MIN_MV &&
+			result.vbat_mv <= SELFTEST_VBAT_MAX_MV &&
+			result.open_mv >= on_mv + SELFTEST_DIV_DELTA_MV;
+}
+
+static void test_led(void)
+{
+	/* Input buffer stays connected so the pad level can be read back;
+	 * a pad shorted to either rail fails one of the two reads.
+	 */
+	if (gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE | GPIO_INPUT) < 0) {
+		return;
+	}
+	k_busy_wait(10);
+	bool on = gpio_pin_get_dt(&led) == 1;
+
+	gpio_pin_set_dt(&led, 0);
+	k_busy_wait(10);
+	bool off = gpio_pin_get_dt(&led) == 0;
+
+	result.led_ok = on && off;
+}
+
+static bool radio_wait_event(nrf_radio_event_t event)
+{
+	for (int i = 0; i < RADIO_EVENT_TIMEOUT_US; i++) {
+		if (nrf_radio_event_check(NRF_RADIO, event)) {
+			nrf_radio_event_clear(NRF_RADIO, event);
+			return true;
+		}
+		k_busy_wait(1);
+	}
+	return false;
+}
+
+/* Energy detect on channels 11-26 straight on the RADIO registers.
+ * The 802.15.4 driver is idle (ZBOSS is not started in this mode);
+ * its interrupt is masked for the duration of the scan.
+ */
+static void test_radio(void)
+{
+	struct onoff_manager *hf_mgr =
+		z_nrf_clock_control_get_onoff(CLOCK_CONTROL_NRF_SUBSYS_HF);
+	struct onoff_client hf_cli;
+	int res;
+	bool ok = true;
+
+	sys_notify_init_spinwait(&hf_cli.notify);
+	if (onoff_request(hf_mgr, &hf_cli) < 0) {
+		return;
+	}
+	while (sys_notify_fetch_result(&hf_cli.notify, &res) == -EAGAIN) {
+	}
+
+	irq_disable(RADIO_IRQn);
+
+	result.ed_max_dbm = INT8_MIN;
+	nrf_radio_mode_set(NRF_RADIO, NRF_RADIO_MODE_IEEE802154_250KBIT);
+	nrf_radio_ed_loop_count_set(NRF_RADIO, 0);
+
+	for (uint8_t ch = 11; ch <= 26 && ok; ch++) {
+		nrf_radio_frequency_set(NRF_RADIO, 2405 + 5 * (ch - 11));
+
+		nrf_radio_event_clear(NRF_RADIO, NRF_RADIO_EVENT_READY);
+		nrf_radio_task_trigger(NRF_RADIO, NRF_RADIO_TASK_RXEN);
+		ok = radio_wait_event(NRF_RADIO_EVENT_READY);
+
+		if (ok) {
+			nrf_radio_event_clear(NRF_RADIO, NRF_RADIO_EVENT_EDEND);
+			nrf_radio_task_trigger(NRF_RADIO, NRF_RADIO_TASK_EDSTART);
+			ok = radio_wait_event(NRF_RADIO_EVENT_EDEND);
+		}
+
+		if (ok) {
+			int dbm = RADIO_ED_RSSIOFFS +
+				  RADIO_ED_RSSISCALE * nrf_radio_ed_sample_get(NRF_RADIO);
+
+			if (dbm > result.ed_max_dbm) {
+				result.ed_max_dbm = (int8_t)dbm;
+				result.ed_max_channel = ch;
+			}
+		}
+
+		nrf_radio_event_clear(NRF_RADIO, NRF_RADIO_EVENT_DISABLED);
+		nrf_radio_task_trigger(NRF_RADIO, NRF_RADIO_TASK_DISABLE);
+		(void)radio_wait_event(NRF_RADIO_EVENT_DISABLED);
+	}
+
+	NVIC_ClearPendingIRQ(RADIO_IRQn);
+	irq_enable(RADIO_IRQn);
+	onoff_release(hf_mgr);
+
+	result.radio_ok = ok;
+}
+
+static void print_result(void)
+{
+	uint8_t id[8] = {0};
+	bool pass = result.sht_ok && result.adc_ok && result.led_ok &&
+		    result.radio_ok;
+
+	(void)hwinfo_get_device_id(id, sizeof(id));
+
+	printk("SELFTEST {\"v\":%d,\"pass\":%d,\"ms\":%u,"
+	       "\"id\":\"%02x%02x%02x%02x%02x%02x%02x%02x\",\"sht\":[",
+	       SELFTEST_FORMAT_VERSION, pass, result.elapsed_ms,
+	       id[0], id[1], id[2], id[3], id[4], id[5], id[6], id[7]);
+	for (int i = 0; i < SHT4X_COUNT; i++) {
+		const struct sht_result *sht = &result.sht[i];
+
+		printk("%s{\"ok\":%d,\"sn\":\"%08x\",\"t\":%d,\"h\":%u}",
+		       i > 0 ? "," : "", sht->ok, sht->serial, sht->temp, sht->hum);
+	}
+	printk("],\"adc\":{\"ok\":%d,\"vbat\":%d,\"open\":%d},"
+	       "\"led\":{\"ok\":%d},"
+	       "\"radio\":{\"ok\":%d,\"ed\":%d,\"ch\":%u}}\n",
+	       result.adc_ok, result.vbat_mv, result.open_mv,
+	       result.led_ok,
+	       result.radio_ok, result.ed_max_dbm, result.ed_max_channel);
+}
+
+FUNC_NORETURN void selftest_run(void)
+{
+	int64_t start = k_uptime_get();
+	bool pass;
+	uint32_t dtr_prev = 0;
+
+	test_sht();
+	test_adc();
+	test_led();
+	test_radio();
+
+	result.elapsed_ms = (uint32_t)(k_uptime_get() - start);
+	pass = result.sht_ok && result.adc_ok && result.led_ok &&
+	       result.radio_ok;
+
+	/* LED: steady on = pass, fast blink = fail */
+	gpio_pin_configure_dt(&led, GPIO_OUTPUT_INACTIVE);
+
+	while (1) {
+		uint32_t dtr = 0;
+
+		(void)uart_line_ctrl_get(console, UART_LINE_CTRL_DTR, &dtr);
+		if (dtr && !dtr_prev) {
+			print_result();
+		}
+		dtr_prev = dtr;
+
+		if (pass) {
+			gpio_pin_set_dt(&led, 1);
+		} else {
+			gpio_pin_toggle_dt(&led);
+		}
+		k_msleep(100);
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * Frostbee - Manufacturing self-test
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SELFTEST_H
+#define SELFTEST_H 1
+
+#include <stdbool.h>
+
+#if defined(CONFIG_FROSTBEE_SELFTEST)
+
+/** @brief Whether a button held at boot should enter the self-test.
+ *
+ * False after a software reset, so the reboot that follows a 5 s
+ * factory reset (button still held) does not end up here.
+ */
+bool selftest_requested(void);
+
+/** @brief Run the self-test and report over the console. Does not return. */
+FUNC_NORETURN void selftest_run(void);
+
+#else
+
+static inline bool selftest_requested(void)
+{
+	return false;
+}
+
+static inline void selftest_run(void)
+{
+}
+
+#endif /* CONFIG_FROSTBEE_SELFTEST */
+
+#endif /* SELFTEST_H */
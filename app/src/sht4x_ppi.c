@@ -0,0 +1,172 @@
+/*
+ * Frostbee - Hardware-sequenced SHT4x measurement (RTC2 + PPI + TWIM)
+ *
+ * The driver path wakes the CPU three times per reading: TWIM end of
+ * the command write, the conversion timer, TWIM end of the read.  Here
+ * the whole sequence is armed up front:
+ *
+ *   RTC2 CC[0] --PPI--> TWIM STARTTX   (measure command, LASTTX->STOP)
+ *   RTC2 CC[1] --PPI--> TWIM STARTRX   (6 bytes by EasyDMA, LASTRX->STOP)
+ *   RTC2 CC[2] --IRQ--> wake the reading thread
+ *
+ * and the CPU only runs again to check CRCs and convert.  RTC2 is not
+ * used by the kernel (RTC1) or MPSL (RTC0).  The TWIM belongs to the
+ * Zephyr I2C driver; it is borrowed with its interrupts masked and
+ * handed back with the driver's settings restored, which is safe
+ * because every transfer on this bus runs under sensor_mutex.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT sensirion_sht4x
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/irq.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device_runtime.h>
+#include <hal/nrf_rtc.h>
+#include <hal/nrf_twim.h>
+#include <helpers/nrfx_gppi.h>
+
+#include "sht4x_ppi.h"
+
+LOG_MODULE_REGISTER(sht4x_ppi, LOG_LEVEL_INF);
+
+#define SHT4X_RTC      NRF_RTC2
+#define SHT4X_RTC_IRQ  RTC2_IRQn
+#define SHT4X_TWIM     ((NRF_TWIM_Type *)DT_REG_ADDR(DT_INST_BUS(0)))
+
+/* LFCLK ticks; CC[0] must be at least COUNTER + 2 to fire reliably */
+#define RTC_START_TICKS  2
+#define RTC_HZ           32768
+/* Address + 6 bytes at 100 kHz is ~0.7 ms; allow 1.5 ms */
+#define READ_WINDOW_US   1500
+
+static const struct device *bus;
+static uint8_t sensor_addr;
+
+/* EasyDMA buffers must live in RAM */
+static uint8_t tx_buf[1];
+static uint8_t rx_buf[6];
+
+static uint8_t ppi_tx;
+static uint8_t ppi_rx;
+
+static K_SEM_DEFINE(done_sem, 0, 1);
+
+static uint32_t us_to_ticks(uint32_t us)
+{
+	return DIV_ROUND_UP((uint64_t)us * RTC_HZ, USEC_PER_SEC);
+}
+
+static void rtc_isr(const void *arg)
+{
+	ARG_UNUSED(arg);
+
+	nrf_rtc_task_trigger(SHT4X_RTC, NRF_RTC_TASK_STOP);
+	nrf_rtc_event_clear(SHT4X_RTC, NRF_RTC_EVENT_COMPARE_2);
+	k_sem_give(&done_sem);
+}
+
+int sht4x_ppi_init(const struct i2c_dt_spec *spec)
+{
+	NRF_TWIM_Type *twim = SHT4X_TWIM;
+
+	bus = spec->bus;
+	sensor_addr = spec->addr;
+
+	if (nrfx_gppi_channel_alloc(&ppi_tx) != NRFX_SUCCESS ||
+	    nrfx_gppi_channel_alloc(&ppi_rx) != NRFX_SUCCESS) {
+		LOG_ERR("No free PPI channels");
+		return -EBUSY;
+	}
+
+	nrfx_gppi_channel_endpoints_setup(
+		ppi_tx,
+		nrf_rtc_event_address_get(SHT4X_RTC, NRF_RTC_EVENT_COMPARE_0),
+		nrf_twim_task_address_get(twim, NRF_TWIM_TASK_STARTTX));
+	nrfx_gppi_channel_endpoints_setup(
+		ppi_rx,
+		nrf_rtc_event_address_get(SHT4X_RTC, NRF_RTC_EVENT_COMPARE_1),
+		nrf_twim_task_address_get(twim, NRF_TWIM_TASK_STARTRX));
+	nrfx_gppi_channels_enable(BIT(ppi_tx) | BIT(ppi_rx));
+
+	nrf_rtc_prescaler_set(SHT4X_RTC, 0);
+	nrf_rtc_event_enable(SHT4X_RTC, NRF_RTC_INT_COMPARE0_MASK |
+					NRF_RTC_INT_COMPARE1_MASK);
+	nrf_rtc_int_enable(SHT4X_RTC, NRF_RTC_INT_COMPARE2_MASK);
+
+	IRQ_CONNECT(SHT4X_RTC_IRQ, 1, rtc_isr, NULL, 0);
+	irq_enable(SHT4X_RTC_IRQ);
+
+	LOG_INF("SHT4x measurements sequenced by RTC2/PPI (ch %u, %u)",
+		ppi_tx, ppi_rx);
+	return 0;
+}
+
+int sht4x_ppi_measure(uint8_t cmd, uint8_t wait_ms, uint8_t rx[6])
+{
+	NRF_TWIM_Type *twim = SHT4X_TWIM;
+	uint32_t cc_rx = RTC_START_TICKS + us_to_ticks(wait_ms * USEC_PER_MSEC);
+	uint32_t cc_done = cc_rx + us_to_ticks(READ_WINDOW_US);
+	uint32_t saved_int;
+	int ret;
+
+	ret = pm_device_runtime_get(bus);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* Borrow the TWIM from the driver */
+	saved_int = nrf_twim_int_enable_check(twim, NRF_TWIM_ALL_INTS_MASK);
+	nrf_twim_int_disable(twim, NRF_TWIM_ALL_INTS_MASK);
+
+	tx_buf[0] = cmd;
+	nrf_twim_address_set(twim, sensor_addr);
+	nrf_twim_tx_buffer_set(twim, tx_buf, sizeof(tx_buf));
+	nrf_twim_rx_buffer_set(twim, rx_buf, sizeof(rx_buf));
+	nrf_twim_shorts_set(twim, NRF_TWIM_SHORT_LASTTX_STOP_MASK |
+				  NRF_TWIM_SHORT_LASTRX_STOP_MASK);
+	nrf_twim_event_clear(twim, NRF_TWIM_EVENT_STOPPED);
+	nrf_twim_event_clear(twim, NRF_TWIM_EVENT_ERROR);
+	(void)nrf_twim_errorsrc_get_and_clear(twim);
+
+	/* Arm the timeline and let the hardware run it */
+	nrf_rtc_task_trigger(SHT4X_RTC, NRF_RTC_TASK_CLEAR);
+	nrf_rtc_event_clear(SHT4X_RTC, NRF_RTC_EVENT_COMPARE_0);
+	nrf_rtc_event_clear(SHT4X_RTC, NRF_RTC_EVENT_COMPARE_1);
+	nrf_rtc_event_clear(SHT4X_RTC, NRF_RTC_EVENT_COMPARE_2);
+	nrf_rtc_cc_set(SHT4X_RTC, 0, RTC_START_TICKS);
+	nrf_rtc_cc_set(SHT4X_RTC, 1, cc_rx);
+	nrf_rtc_cc_set(SHT4X_RTC, 2, cc_done);
+	k_sem_reset(&done_sem);
+	nrf_rtc_task_trigger(SHT4X_RTC, NRF_RTC_TASK_START);
+
+	if (k_sem_take(&done_sem, K_MSEC(wait_ms + 10)) < 0) {
+		nrf_rtc_task_trigger(SHT4X_RTC, NRF_RTC_TASK_STOP);
+		LOG_ERR("RTC sequence did not complete");
+		ret = -ETIMEDOUT;
+	} else if (nrf_twim_event_check(twim, NRF_TWIM_EVENT_ERROR)) {
+		/* NACK: the shorts do not fire, release the bus ourselves */
+		LOG_ERR("TWIM error 0x%x", nrf_twim_errorsrc_get_and_clear(twim));
+		nrf_twim_task_trigger(twim, NRF_TWIM_TASK_STOP);
+		WAIT_FOR(nrf_twim_event_check(twim, NRF_TWIM_EVENT_STOPPED), 1000, );
+		ret = -EIO;
+	} else if (nrf_twim_rxd_amount_get(twim) != sizeof(rx_buf)) {
+		LOG_ERR("Short read (%u bytes)", nrf_twim_rxd_amount_get(twim));
+		ret = -EIO;
+	} else {
+		memcpy(rx, rx_buf, sizeof(rx_buf));
+	}
+
+	/* Hand the TWIM back as the driver left it */
+	nrf_twim_shorts_set(twim, 0);
+	nrf_twim_event_clear(twim, NRF_TWIM_EVENT_STOPPED);
+	nrf_twim_event_clear(twim, NRF_TWIM_EVENT_ERROR);
+	nrf_twim_int_enable(twim, saved_int);
+
+	(void)pm_device_runtime_put(bus);
+	return ret;
+}
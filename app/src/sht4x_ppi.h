@@ -0,0 +1,47 @@
+/*
+ * Frostbee - Hardware-sequenced SHT4x measurement (RTC2 + PPI + TWIM)
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SHT4X_PPI_H
+#define SHT4X_PPI_H 1
+
+#include <errno.h>
+#include <stdint.h>
+#include <zephyr/drivers/i2c.h>
+
+#if defined(CONFIG_FROSTBEE_SHT4X_PPI)
+
+/** @brief Allocate PPI channels and hook up RTC2 for the sensor at @p spec. */
+int sht4x_ppi_init(const struct i2c_dt_spec *spec);
+
+/** @brief Run one measurement without CPU involvement until the result is in.
+ *
+ * RTC2 compare events start the command write and, @p wait_ms later,
+ * the 6-byte read through PPI; the calling thread sleeps until the
+ * read window has passed.
+ *
+ * @return 0 with the raw sensor response in @p rx, negative errno otherwise.
+ */
+int sht4x_ppi_measure(uint8_t cmd, uint8_t wait_ms, uint8_t rx[6]);
+
+#else
+
+static inline int sht4x_ppi_init(const struct i2c_dt_spec *spec)
+{
+	ARG_UNUSED(spec);
+	return 0;
+}
+
+static inline int sht4x_ppi_measure(uint8_t cmd, uint8_t wait_ms, uint8_t rx[6])
+{
+	ARG_UNUSED(cmd);
+	ARG_UNUSED(wait_ms);
+	ARG_UNUSED(rx);
+	return -ENOTSUP;
+}
+
+#endif /* CONFIG_FROSTBEE_SHT4X_PPI */
+
+#endif /* SHT4X_PPI_H */
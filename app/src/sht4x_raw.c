@@ -0,0 +1,232 @@
+/*
+ * Frostbee - Batched SHT4x access
+ *
+ * The Zephyr sensor API fetches one device at a time (command, wait,
+ * read), so N sensors cost N conversion waits and N wake-ups.  Talking
+ * to the sensors directly lets all conversions run in parallel: one
+ * command per sensor, one sleep, one read per sensor.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT sensirion_sht4x
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "sht4x_raw.h"
+#include "sht4x_ppi.h"
+
+LOG_MODULE_REGISTER(sht4x_raw, LOG_LEVEL_INF);
+
+/* Measure commands and max. conversion times by repeatability
+ * (devicetree "repeatability": 0 = low, 1 = medium, 2 = high).
+ */
+static const uint8_t measure_cmd[] = { 0xE0, 0xF6, 0xFD };
+static const uint8_t measure_wait_ms[] = { 2, 5, 9 };
+
+#define SHT4X_CRC_INIT  0xFF
+
+/* CRC-8, polynomial 0x31 (x^8 + x^5 + x^4 + 1), one lookup per byte */
+static const uint8_t sht4x_crc_table[256] = {
+	0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+	0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+	0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+	0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+	0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+	0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+	0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+	0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+	0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+	0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+	0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+	0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+	0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+	0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+	0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+	0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+	0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+	0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+	0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+	0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+	0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+	0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+	0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+	0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+	0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+	0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+	0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+	0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+	0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+	0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+	0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+	0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+};
+
+struct sht4x_cfg {
+	struct i2c_dt_spec i2c;
+	uint8_t repeatability;
+};
+
+#define SHT4X_CFG(inst)                                         \
+	{                                                       \
+		.i2c = I2C_DT_SPEC_INST_GET(inst),              \
+		.repeatability = DT_INST_PROP(inst, repeatability), \
+	},
+
+static const struct sht4x_cfg sensors[SHT4X_COUNT] = {
+	DT_INST_FOREACH_STATUS_OKAY(SHT4X_CFG)
+};
+
+int sht4x_raw_init(void)
+{
+	for (int i = 0; i < SHT4X_COUNT; i++) {
+		if (!i2c_is_ready_dt(&sensors[i].i2c)) {
+			LOG_ERR("SHT4x zone %d: bus not ready", i + 1);
+			return -ENODEV;
+		}
+
+#if defined(CONFIG_FROSTBEE_SHT4X_I2C_FAST)
+		/* SHT4x supports Fast-mode; a 6-byte read then takes ~0.2 ms
+		 * of bus time instead of ~0.7 ms.  Keep the devicetree speed
+		 * if the controller refuses.
+		 */
+		int ret = i2c_configure(sensors[i].i2c.bus,
+					I2C_SPEED_SET(I2C_SPEED_FAST) |
+					I2C_MODE_CONTROLLER);
+		if (ret < 0) {
+			LOG_WRN("SHT4x zone %d: 400 kHz not available (%d)", i + 1, ret);
+		}
+#endif
+	}
+
+	LOG_INF("%d SHT4x sensor(s) configured", SHT4X_COUNT);
+	return sht4x_ppi_init(&sensors[0].i2c);
+}
+
+/* CRC of one big-endian 16-bit word as sent by the sensor */
+static inline uint8_t sht4x_crc(const uint8_t word[2])
+{
+	return sht4x_crc_table[sht4x_crc_table[SHT4X_CRC_INIT ^ word[0]] ^ word[1]];
+}
+
+static bool sht4x_unpack(const uint8_t rx[6], struct sht4x_sample *sample)
+{
+	if (sht4x_crc(&rx[0]) != rx[2] || sht4x_crc(&rx[3]) != rx[5]) {
+		return false;
+	}
+
+	/* Scaling to ZCL units is done per channel (frostbee_channels.h) */
+	sample->t_ticks = sys_get_be16(&rx[0]);
+	sample->rh_ticks = sys_get_be16(&rx[3]);
+	return true;
+}
+
+#if defined(CONFIG_FROSTBEE_SHT4X_PPI)
+BUILD_ASSERT(SHT4X_COUNT == 1, "PPI-sequenced reads support a single SHT4x");
+
+int sht4x_raw_read_all(struct sht4x_sample samples[SHT4X_COUNT])
+{
+	const struct sht4x_cfg *cfg = &sensors[0];
+	uint8_t rx[6];
+
+	samples[0].valid =
+		sht4x_ppi_measure(measure_cmd[cfg->repeatability],
+				  measure_wait_ms[cfg->repeatability], rx) == 0 &&
+		sht4x_unpack(rx, &samples[0]);
+
+	return samples[0].valid ? 1 : 0;
+}
+
+int sht4x_raw_start(void)
+{
+	/* The hardware sequence always runs start to finish */
+	return -ENOTSUP;
+}
+#else
+/* An early conversion collected later than this is stale (e.g. the boot
+ * conversion when steering takes minutes) and is measured again
+ */
+#define CONVERSION_MAX_AGE_MS  5000
+
+/* Conversions in flight, started by sht4x_raw_start() */
+static bool cmd_ok[SHT4X_COUNT];
+static bool conversion_pending;
+static int64_t conversion_done_at;
+
+int sht4x_raw_start(void)
+{
+	uint8_t wait_ms = 0;
+	int started = 0;
+
+	for (int i = 0; i < SHT4X_COUNT; i++) {
+		const struct sht4x_cfg *cfg = &sensors[i];
+		uint8_t cmd = measure_cmd[cfg->repeatability];
+
+		cmd_ok[i] = i2c_write_dt(&cfg->i2c, &cmd, 1) == 0;
+		if (!cmd_ok[i]) {
+			LOG_ERR("SHT4x zone %d: measure command failed", i + 1);
+			continue;
+		}
+		wait_ms = MAX(wait_ms, measure_wait_ms[cfg->repeatability]);
+		started++;
+	}
+
+	/* +1 ms: k_uptime_get() truncates to the millisecond */
+	conversion_done_at = k_uptime_get() + wait_ms + 1;
+	conversion_pending = true;
+
+	return started > 0 ? 0 : -EIO;
+}
+
+int sht4x_raw_read_all(struct sht4x_sample samples[SHT4X_COUNT])
+{
+	int64_t remaining;
+	int valid = 0;
+
+	/* 1. Start all conversions, unless a recent one is in flight.  A new
+	 * measure command replaces an unread result.
+	 */
+	if (!conversion_pending ||
+	    k_uptime_get() - conversion_done_at > CONVERSION_MAX_AGE_MS) {
+		if (conversion_pending) {
+			LOG_DBG("Early conversion too old, measuring again");
+		}
+		(void)sht4x_raw_start();
+	}
+	conversion_pending = false;
+
+	/* 2. One wait for the slowest sensor (none if started early enough) */
+	remaining = conversion_done_at - k_uptime_get();
+	if (remaining > 0) {
+		k_msleep(remaining);
+	}
+
+	/* 3. Collect results */
+	for (int i = 0; i < SHT4X_COUNT; i++) {
+		uint8_t rx[6];
+
+		samples[i].valid = cmd_ok[i];
+		if (!samples[i].valid) {
+			continue;
+		}
+
+		if (i2c_read_dt(&sensors[i].i2c, rx, sizeof(rx)) < 0) {
+			LOG_ERR("SHT4x zone %d: read failed", i + 1);
+			samples[i].valid = false;
+			continue;
+		}
+
+		samples[i].valid = sht4x_unpack(rx, &samples[i]);
+		if (!samples[i].valid) {
+			LOG_ERR("SHT4x zone %d: CRC mismatch", i + 1);
+			continue;
+		}
+		valid++;
+	}
+
+	return valid;
+}
+#endif /* CONFIG_FROSTBEE_SHT4X_PPI */
@@ -0,0 +1,68 @@
+/*
+ * Frostbee - Batched SHT4x access
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SHT4X_RAW_H
+#define SHT4X_RAW_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+
+/* Every enabled "sensirion,sht4x" node is one zone, in devicetree order;
+ * arrays are indexed from 0, zones are numbered from 1 like endpoints
+ */
+#define SHT4X_COUNT  DT_NUM_INST_STATUS_OKAY(sensirion_sht4x)
+
+BUILD_ASSERT(SHT4X_COUNT >= 1, "at least one sensirion,sht4x node required");
+
+/** @brief One zone's raw reading. */
+struct sht4x_sample {
+	uint16_t t_ticks;
+	uint16_t rh_ticks;
+	bool     valid;  /* I2C transfer and both CRCs OK */
+};
+
+/* Datasheet: T = -45 + 175 * ticks / 65535, RH = -6 + 125 * ticks / 65535,
+ * scaled by 100 for ZCL.  Dividing by 2^16 instead of 65535 turns this
+ * into one multiply and shift (17500 / 2^16 = 4375 / 2^14, 12500 / 2^16 =
+ * 3125 / 2^14).  Before truncation the result is at most 0.27 centi-units
+ * low; after it, up to 1 (0.01 degC / 0.01 %RH, e.g. 12999 instead of
+ * 13000 at 65535 ticks), below the sensor's repeatability (0.04 degC /
+ * 0.08 %RH at high repeatability).  Products stay below 2^29, so 32-bit
+ * math suffices.
+ * Humidity is clipped to 0-100 %RH.
+ */
+#define SHT4X_TICKS_TO_TEMP(t) \
+	((int16_t)((((int32_t)(t) * 4375) >> 14) - 4500))
+#define SHT4X_TICKS_TO_HUM(t) \
+	((uint16_t)CLAMP((((int32_t)(t) * 3125) >> 14) - 600, 0, 10000))
+
+/** @brief Check that every sensor's bus is ready. */
+int sht4x_raw_init(void);
+
+/** @brief Send the measure command to every sensor and return at once.
+ *
+ * Lets the conversion overlap other work (e.g. ZBOSS restoring its
+ * state at boot); the next sht4x_raw_read_all() collects the results.
+ *
+ * @return 0 if at least one conversion started, -EIO if none did,
+ *         -ENOTSUP when reads are hardware-sequenced (nothing started).
+ */
+int sht4x_raw_start(void);
+
+/** @brief Measure all sensors with a single wait.
+ *
+ * Sends the measure command to every sensor (unless sht4x_raw_start()
+ * did so within the last few seconds; an older conversion is discarded
+ * and measured again), sleeps once for whatever remains of the slowest
+ * conversion, then reads all results.
+ *
+ * @return Number of valid samples.
+ */
+int sht4x_raw_read_all(struct sht4x_sample samples[SHT4X_COUNT]);
+
+#endif /* SHT4X_RAW_H */
@@ -0,0 +1,365 @@
+/*
+ * Frostbee - Sleep-blocker instrumentation
+ *
+ * Answers "what kept the SoC from its 2-3 uA idle" per subsystem instead
+ * of by guesswork.  Two sources are combined:
+ *
+ *   - CPU: cumulative run time of every thread (ZBOSS, system workqueue
+ *     with the button/debounce work, logging, USB, main) from the
+ *     kernel's thread runtime statistics.  The idle thread's share is
+ *     the time the CPU actually slept.
+ *   - Blockers: every time the kernel enters idle (tracing idle hook),
+ *     the probe records which of HFXO, the radio, USBD, UARTE, TWIM and
+ *     SAADC are still enabled and which watched delayed work items are
+ *     pending (each one means a timer wake-up to come).  The next
+ *     interrupt ends the idle period, and its length is charged to
+ *     every blocker recorded at entry.  Idle periods with no blocker
+ *     are the ones spent at the floor current.
+ *
+ * No timer of its own: the probe adds no wake-ups.  Zero-latency
+ * interrupts (MPSL radio timing) bypass the tracing hooks, so a period
+ * they interrupt is counted until the next regular interrupt.
+ *
+ * Cumulative totals and the change since the previous report are
+ * logged every CONFIG_FROSTBEE_SLEEP_PROBE_REPORT_S.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/logging/log.h>
+#include <tracing_user.h>
+#include <hal/nrf_clock.h>
+#include <hal/nrf_radio.h>
+
+#include "sleep_probe.h"
+
+LOG_MODULE_REGISTER(sleep_probe, LOG_LEVEL_INF);
+
+#define REPORT_S   CONFIG_FROSTBEE_SLEEP_PROBE_REPORT_S
+
+#define MAX_WATCHED_WORK  4
+
+struct blocker {
+	const char *name;
+	bool (*active)(const struct blocker *b);
+	struct k_work_delayable *dwork;
+	uint64_t cycles;       /* idle time with this blocker, cumulative */
+	uint32_t entries;      /* idle entries with this blocker */
+	uint64_t cycles_reported;
+};
+
+/* ─── Peripheral probes ─── */
+
+/* Peripheral instances the application enables in the devicetree */
+#define PERIPH_REG(node_id, type)  (type *)DT_REG_ADDR(node_id),
+#define BUS_REG(node_id, type)     (type *)DT_REG_ADDR(DT_BUS(node_id)),
+
+static bool hfxo_active(const struct blocker *b)
+{
+	nrf_clock_hfclk_t src;
+
+	ARG_UNUSED(b);
+	return nrf_clock_is_running(NRF_CLOCK, NRF_CLOCK_DOMAIN_HFCLK, &src) &&
+	       src == NRF_CLOCK_HFCLK_HIGH_ACCURACY;
+}
+
+static bool radio_active(const struct blocker *b)
+{
+	ARG_UNUSED(b);
+	return nrf_radio_state_get(NRF_RADIO) != NRF_RADIO_STATE_DISABLED;
+}
+
+#if DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_usbd)
+static NRF_USBD_Type *const usbd_regs[] = {
+	DT_FOREACH_STATUS_OKAY_VARGS(nordic_nrf_usbd, PERIPH_REG, NRF_USBD_Type)
+};
+
+static bool usbd_active(const struct blocker *b)
+{
+	ARG_UNUSED(b);
+	for (size_t i = 0; i < ARRAY_SIZE(usbd_regs); i++) {
+		if (usbd_regs[i]->ENABLE != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+#if DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_uarte)
+static NRF_UARTE_Type *const uarte_regs[] = {
+	DT_FOREACH_STATUS_OKAY_VARGS(nordic_nrf_uarte, PERIPH_REG, NRF_UARTE_Type)
+};
+
+static bool uarte_active(const struct blocker *b)
+{
+	ARG_UNUSED(b);
+	for (size_t i = 0; i < ARRAY_SIZE(uarte_regs); i++) {
+		if (uarte_regs[i]->ENABLE != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+/* The buses the SHT4x sensors sit on (duplicates are harmless) */
+#if DT_HAS_COMPAT_STATUS_OKAY(sensirion_sht4x)
+static NRF_TWIM_Type *const twim_regs[] = {
+	DT_FOREACH_STATUS_OKAY_VARGS(sensirion_sht4x, BUS_REG, NRF_TWIM_Type)
+};
+
+static bool twim_active(const struct blocker *b)
+{
+	ARG_UNUSED(b);
+	for (size_t i = 0; i < ARRAY_SIZE(twim_regs); i++) {
+		if (twim_regs[i]->ENABLE != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+#if DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_saadc)
+static NRF_SAADC_Type *const saadc_regs[] = {
+	DT_FOREACH_STATUS_OKAY_VARGS(nordic_nrf_saadc, PERIPH_REG, NRF_SAADC_Type)
+};
+
+static bool saadc_active(const struct blocker *b)
+{
+	ARG_UNUSED(b);
+	for (size_t i = 0; i < ARRAY_SIZE(saadc_regs); i++) {
+		if (saadc_regs[i]->ENABLE != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+static bool work_pending(const struct blocker *b)
+{
+	return k_work_delayable_is_pending(b->dwork);
+}
+
+#define BUILTIN_BLOCKERS                                   \
+	(2 + DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_usbd) +   \
+	 DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_uarte) +      \
+	 DT_HAS_COMPAT_STATUS_OKAY(sensirion_sht4x) +       \
+	 DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_saadc))
+
+static struct blocker blockers[BUILTIN_BLOCKERS + MAX_WATCHED_WORK] = {
+	{ .name = "hfxo",  .active = hfxo_active },
+	{ .name = "radio", .active = radio_active },
+#if DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_usbd)
+	{ .name = "usbd",  .active = usbd_active },
+#endif
+#if DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_uarte)
+	{ .name = "uarte", .active = uarte_active },
+#endif
+#if DT_HAS_COMPAT_STATUS_OKAY(sensirion_sht4x)
+	{ .name = "twim",  .active = twim_active },
+#endif
+#if DT_HAS_COMPAT_STATUS_OKAY(nordic_nrf_saadc)
+	{ .name = "saadc", .active = saadc_active },
+#endif
+};
+static size_t blocker_count = BUILTIN_BLOCKERS;
+
+void sleep_probe_watch_work(const char *name, struct k_work_delayable *dwork)
+{
+	unsigned int key;
+
+	if (blocker_count == ARRAY_SIZE(blockers)) {
+		LOG_WRN("No slot left to watch %s", name);
+		return;
+	}
+
+	key = irq_lock();
+	blockers[blocker_count] = (struct blocker){
+		.name = name,
+		.active = work_pending,
+		.dwork = dwork,
+	};
+	blocker_count++;
+	irq_unlock(key);
+}
+
+/* ─── Idle hooks ─── */
+
+/* Current idle period; both hooks run with interrupts locked */
+static bool probe_running;
+static bool in_idle;
+static uint32_t idle_entered_at;
+static uint32_t idle_blockers;     /* bit per blockers[] entry */
+
+/* All idle periods, and those with no blocker active */
+static uint64_t idle_cycles;
+static uint64_t clean_cycles;
+static uint32_t idle_entries;
+
+BUILD_ASSERT(ARRAY_SIZE(blockers) <= 32, "blocker mask is 32 bits");
+
+void sys_trace_idle_user(void)
+{
+	uint32_t mask = 0;
+
+	if (!probe_running) {
+		return;
+	}
+
+	for (size_t i = 0; i < blocker_count; i++) {
+		if (blockers[i].active(&blockers[i])) {
+			mask |= BIT(i);
+		}
+	}
+
+	idle_blockers = mask;
+	idle_entered_at = k_cycle_get_32();
+	in_idle = true;
+}
+
+void sys_trace_isr_enter_user(int nested_interrupts)
+{
+	uint32_t slept;
+
+	ARG_UNUSED(nested_interrupts);
+
+	if (!in_idle) {
+		return;
+	}
+	in_idle = false;
+
+	slept = k_cycle_get_32() - idle_entered_at;
+	idle_cycles += slept;
+	idle_entries++;
+
+	if (idle_blockers == 0) {
+		clean_cycles += slept;
+		return;
+	}
+
+	for (size_t i = 0; i < blocker_count; i++) {
+		if (idle_blockers & BIT(i)) {
+			blockers[i].cycles += slept;
+			blockers[i].entries++;
+		}
+	}
+}
+
+/* ─── Reporting ─── */
+
+/* Thread run time at the previous report, keyed by thread pointer */
+#define MAX_THREADS  16
+
+static struct {
+	const struct k_thread *thread;
+	uint64_t cycles;
+} thread_prev[MAX_THREADS];
+
+static uint64_t *thread_prev_slot(const struct k_thread *thread)
+{
+	for (int i = 0; i < MAX_THREADS; i++) {
+		if (thread_prev[i].thread == thread) {
+			return &thread_prev[i].cycles;
+		}
+		if (thread_prev[i].thread == NULL) {
+			thread_prev[i].thread = thread;
+			return &thread_prev[i].cycles;
+		}
+	}
+	return NULL;
+}
+
+static uint32_t cycles_to_ms(uint64_t cycles)
+{
+	return (uint32_t)((cycles * MSEC_PER_SEC) / sys_clock_hw_cycles_per_sec());
+}
+
+static void thread_report(const struct k_thread *cthread, void *user_data)
+{
+	struct k_thread *thread = (struct k_thread *)cthread;
+	k_thread_runtime_stats_t stats;
+	const char *name = k_thread_name_get(thread);
+	uint64_t *prev;
+
+	ARG_UNUSED(user_data);
+
+	if (k_thread_runtime_stats_get(thread, &stats) < 0) {
+		return;
+	}
+
+	prev = thread_prev_slot(thread);
+	LOG_INF("  thread %-12s %8u ms (+%u)",
+		name != NULL ? name : "?",
+		cycles_to_ms(stats.execution_cycles),
+		prev != NULL ? cycles_to_ms(stats.execution_cycles - *prev) : 0);
+	if (prev != NULL) {
+		*prev = stats.execution_cycles;
+	}
+}
+
+static void report_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(report_work, report_handler);
+
+static void report_handler(struct k_work *work)
+{
+	k_thread_runtime_stats_t all;
+	struct blocker snap[ARRAY_SIZE(blockers)];
+	uint64_t idle, clean;
+	uint32_t entries;
+	size_t count;
+	unsigned int key;
+
+	ARG_UNUSED(work);
+
+	/* Consistent copy of the counters the idle hooks update */
+	key = irq_lock();
+	count = blocker_count;
+	memcpy(snap, blockers, sizeof(snap));
+	idle = idle_cycles;
+	clean = clean_cycles;
+	entries = idle_entries;
+	irq_unlock(key);
+
+	if (k_thread_runtime_stats_all_get(&all) == 0) {
+		LOG_INF("Sleep probe @ %lld s: CPU busy %u ms, idle %u ms",
+			k_uptime_get() / MSEC_PER_SEC,
+			cycles_to_ms(all.total_cycles),
+			cycles_to_ms(all.idle_cycles));
+	}
+
+	k_thread_foreach(thread_report, NULL);
+
+	LOG_INF("  idle entries %u: %u ms, %u ms with no blocker",
+		entries, cycles_to_ms(idle), cycles_to_ms(clean));
+
+	for (size_t i = 0; i < count; i++) {
+		LOG_INF("  blocker %-14s %8u ms (+%u) in %u entries",
+			snap[i].name, cycles_to_ms(snap[i].cycles),
+			cycles_to_ms(snap[i].cycles - blockers[i].cycles_reported),
+			snap[i].entries);
+		blockers[i].cycles_reported = snap[i].cycles;
+	}
+
+	k_work_reschedule(&report_work, K_SECONDS(REPORT_S));
+}
+
+int sleep_probe_init(void)
+{
+	unsigned int key = irq_lock();
+
+	probe_running = true;
+	irq_unlock(key);
+
+	k_work_reschedule(&report_work, K_SECONDS(REPORT_S));
+
+	LOG_INF("Sleep probe: %u blockers at idle entry, report every %d s",
+		blocker_count, REPORT_S);
+	return 0;
+}
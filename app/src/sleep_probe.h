@@ -0,0 +1,36 @@
+/*
+ * Frostbee - Sleep-blocker instrumentation
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SLEEP_PROBE_H
+#define SLEEP_PROBE_H 1
+
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_FROSTBEE_SLEEP_PROBE)
+
+/** @brief Start recording blockers at idle entry and periodic reports. */
+int sleep_probe_init(void);
+
+/** @brief Attribute time with @p dwork pending to @p name. */
+void sleep_probe_watch_work(const char *name, struct k_work_delayable *dwork);
+
+#else
+
+static inline int sleep_probe_init(void)
+{
+	return 0;
+}
+
+static inline void sleep_probe_watch_work(const char *name,
+					  struct k_work_delayable *dwork)
+{
+	ARG_UNUSED(name);
+	ARG_UNUSED(dwork);
+}
+
+#endif /* CONFIG_FROSTBEE_SLEEP_PROBE */
+
+#endif /* SLEEP_PROBE_H */
@@ -0,0 +1,101 @@
+/*
+ * Frostbee - VBUS-gated USB CDC console
+ *
+ * The USB device stack is not initialized at boot.  usb_console_init()
+ * enables it once; from then on the nrfx USBD driver only powers the
+ * USBD peripheral (and requests HFXO) while VBUS is detected, and
+ * reports USB_DC_CONNECTED / USB_DC_DISCONNECTED through the status
+ * callback below.  The UART log backend (routed to CDC ACM on the
+ * dongle) follows that state, so on batteries nothing is formatted or
+ * queued for a console nobody is listening to.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/usb/usb_device.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <hal/nrf_power.h>
+
+#include "usb_console.h"
+
+LOG_MODULE_REGISTER(usb_console, LOG_LEVEL_INF);
+
+/* Name given by LOG_BACKEND_DEFINE() in log_backend_uart.c */
+#define CONSOLE_BACKEND_NAME  "log_backend_uart"
+
+static const struct log_backend *console_backend;
+static atomic_t console_active;
+
+static void console_set_active(bool active)
+{
+	if (console_backend == NULL) {
+		return;
+	}
+
+	if (atomic_set(&console_active, active) == active) {
+		return;
+	}
+
+	if (active) {
+		log_backend_enable(console_backend, console_backend->cb->ctx,
+				   CONFIG_LOG_MAX_LEVEL);
+		LOG_INF("VBUS detected - console enabled");
+	} else {
+		/* With LOG_RUNTIME_FILTERING this also drops the backend's
+		 * filter to LOG_LEVEL_NONE, so messages are rejected before
+		 * they are allocated.
+		 */
+		log_backend_disable(console_backend);
+	}
+}
+
+static void usb_status_cb(enum usb_dc_status_code status, const uint8_t *param)
+{
+	ARG_UNUSED(param);
+
+	switch (status) {
+	case USB_DC_CONNECTED:
+		console_set_active(true);
+		break;
+
+	case USB_DC_DISCONNECTED:
+		console_set_active(false);
+		break;
+
+	default:
+		break;
+	}
+}
+
+int usb_console_init(void)
+{
+	int ret;
+
+	console_backend = log_backend_get_by_name(CONSOLE_BACKEND_NAME);
+	if (console_backend == NULL) {
+		LOG_WRN("Console log backend not found");
+	}
+
+	/* The backend autostarts; treat it as active until told otherwise
+	 * so that boot messages still reach a host that is plugged in.
+	 */
+	atomic_set(&console_active, true);
+
+	if (!nrf_power_usbregstatus_vbusdet_get(NRF_POWER)) {
+		console_set_active(false);
+	}
+
+	/* usb_enable() only arms the POWER USB events; the USBD peripheral
+	 * itself is powered up by the driver on USBDETECTED.
+	 */
+	ret = usb_enable(usb_status_cb);
+	if (ret < 0) {
+		LOG_ERR("Failed to enable USB: %d", ret);
+		return ret;
+	}
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+/*
+ * Frostbee - VBUS-gated USB CDC console
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef USB_CONSOLE_H
+#define USB_CONSOLE_H 1
+
+#if defined(CONFIG_FROSTBEE_USB_CONSOLE)
+
+/** @brief Enable the USB stack and gate the log backend on VBUS. */
+int usb_console_init(void);
+
+#else
+
+static inline int usb_console_init(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_FROSTBEE_USB_CONSOLE */
+
+#endif /* USB_CONSOLE_H */
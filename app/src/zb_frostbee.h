@@ -2,35 +2,71 @@
  * Frostbee - Zigbee Device Definition
  *
  * Custom temperature & humidity sensor device with battery reporting.
- * Clusters (server): Basic, Identify, Power Config, Temp Measurement, Humidity
+ * Clusters (server): Basic, Identify, Power Config, one per channel,
+ *                   Groups + Frostbee config (fleet_config.h)
  * Clusters (client): Identify
  *
+ * Additional SHT4x sensors ("zones") each get their own endpoint with
+ * the channel clusters only: zone N is on endpoint FROSTBEE_ENDPOINT +
+ * N - 1 (zone 1 on FROSTBEE_ENDPOINT).  Macros below take the 0-based
+ * sensor index.  Channels
+ * (Temp Measurement, Humidity, ...) come from frostbee_channels.h.
+ *
  * SPDX-License-Identifier: MIT
  */
 
 #ifndef ZB_FROSTBEE_H
 #define ZB_FROSTBEE_H 1
 
+#include "frostbee_channels.h"
+#include "fleet_config.h"
+
 #define FROSTBEE_ENDPOINT              1
 
-#define FROSTBEE_IN_CLUSTER_NUM        5
+/* Basic, Identify (server), Power Config + fleet config + channels */
+#define FROSTBEE_IN_CLUSTER_NUM        \
+	(3 + FLEET_CONFIG_CLUSTER_NUM + FROSTBEE_CHANNEL_COUNT)
 #define FROSTBEE_OUT_CLUSTER_NUM       1
 
-/* Reportable attributes: temperature + humidity + battery percentage */
+/* Reportable attributes: channels + battery percentage */
 #define FROSTBEE_REPORT_ATTR_COUNT     \
-	(ZB_ZCL_TEMP_MEASUREMENT_REPORT_ATTR_COUNT + \
-	 ZB_ZCL_REL_HUMIDITY_MEASUREMENT_REPORT_ATTR_COUNT + \
+	(FROSTBEE_CHANNEL_REPORT_ATTR_COUNT + \
 	 ZB_ZCL_POWER_CONFIG_REPORT_ATTR_COUNT)
 
-/** @brief Declare cluster list for Frostbee sensor device. */
+/** @brief Declare a simple descriptor type with a fixed name.
+ *
+ * Same layout as ZB_DECLARE_SIMPLE_DESC(), which pastes the cluster
+ * counts into the type name and so needs them as literals; here they
+ * are derived from the channel table.
+ */
+#define FROSTBEE_DECLARE_SIMPLE_DESC_TYPE(type_name, in_clust_num, out_clust_num) \
+	typedef ZB_PACKED_PRE struct type_name##_s                                \
+	{                                                                         \
+		zb_uint8_t    endpoint;                                           \
+		zb_uint16_t   app_profile_id;                                     \
+		zb_uint16_t   app_device_id;                                      \
+		zb_bitfield_t app_device_version:4;                               \
+		zb_bitfield_t reserved:4;                                         \
+		zb_uint8_t    app_input_cluster_count;                            \
+		zb_uint8_t    app_output_cluster_count;                           \
+		zb_uint16_t   app_cluster_list[(in_clust_num) + (out_clust_num)]; \
+	} ZB_PACKED_STRUCT type_name##_t
+
+FROSTBEE_DECLARE_SIMPLE_DESC_TYPE(frostbee_simple_desc,
+				  FROSTBEE_IN_CLUSTER_NUM,
+				  FROSTBEE_OUT_CLUSTER_NUM);
+
+/** @brief Declare cluster list for Frostbee sensor device.
+ *
+ * Channel clusters use the zone 1 attribute lists
+ * (FROSTBEE_CH_ATTR_LIST(0, <channel>), sensor index 0).
+ */
 #define ZB_DECLARE_FROSTBEE_CLUSTER_LIST(                            \
 		cluster_list_name,                                   \
 		basic_attr_list,                                     \
 		identify_client_attr_list,                           \
 		identify_server_attr_list,                           \
-		power_config_attr_list,                              \
-		temp_measurement_attr_list,                          \
-		humidity_attr_list)                                   \
+		power_config_attr_list)                              \
 	zb_zcl_cluster_desc_t cluster_list_name[] =                  \
 	{                                                            \
 		ZB_ZCL_CLUSTER_DESC(                                 \
@@ -59,23 +95,8 @@
 			ZB_ZCL_CLUSTER_SERVER_ROLE,                  \
 			ZB_ZCL_MANUF_CODE_INVALID                    \
 		),                                                   \
-		ZB_ZCL_CLUSTER_DESC(                                 \
-			ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,          \
-			ZB_ZCL_ARRAY_SIZE(                           \
-				temp_measurement_attr_list,           \
-				zb_zcl_attr_t),                      \
-			(temp_measurement_attr_list),                 \
-			ZB_ZCL_CLUSTER_SERVER_ROLE,                  \
-			ZB_ZCL_MANUF_CODE_INVALID                    \
-		),                                                   \
-		ZB_ZCL_CLUSTER_DESC(                                 \
-			ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,  \
-			ZB_ZCL_ARRAY_SIZE(                           \
-				humidity_attr_list, zb_zcl_attr_t),  \
-			(humidity_attr_list),                         \
-			ZB_ZCL_CLUSTER_SERVER_ROLE,                  \
-			ZB_ZCL_MANUF_CODE_INVALID                    \
-		),                                                   \
+		FLEET_CONFIG_CLUSTER_DESCS                           \
+		FROSTBEE_CHANNELS(FROSTBEE_CH_CLUSTER_DESC, 0)       \
 		ZB_ZCL_CLUSTER_DESC(                                 \
 			ZB_ZCL_CLUSTER_ID_IDENTIFY,                  \
 			ZB_ZCL_ARRAY_SIZE(                           \
@@ -89,9 +110,7 @@
 
 /** @brief Declare simple descriptor for Frostbee device. */
 #define ZB_ZCL_DECLARE_FROSTBEE_DESC(ep_name, ep_id, in_clust_num, out_clust_num) \
-	ZB_DECLARE_SIMPLE_DESC(in_clust_num, out_clust_num);                      \
-	ZB_AF_SIMPLE_DESC_TYPE(in_clust_num, out_clust_num)                       \
-		simple_desc_##ep_name =                                           \
+	frostbee_simple_desc_t simple_desc_##ep_name =                            \
 	{                                                                         \
 		ep_id,                                                            \
 		ZB_AF_HA_PROFILE_ID,                                              \
@@ -104,8 +123,8 @@
 			ZB_ZCL_CLUSTER_ID_BASIC,                                  \
 			ZB_ZCL_CLUSTER_ID_IDENTIFY,                               \
 			ZB_ZCL_CLUSTER_ID_POWER_CONFIG,                           \
-			ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,                       \
-			ZB_ZCL_CLUSTER_ID_REL_HUMIDITY_MEASUREMENT,               \
+			FLEET_CONFIG_CLUSTER_IDS                                  \
+			FROSTBEE_CHANNELS(FROSTBEE_CH_CLUSTER_ID, 0)              \
 			ZB_ZCL_CLUSTER_ID_IDENTIFY,                               \
 		}                                                                 \
 	}
@@ -131,4 +150,63 @@
 		reporting_info##ep_name,                                           \
 		0, NULL)
 
+/* ─── Zone endpoints (second and further sensors) ─── */
+
+#define FROSTBEE_ZONE_IN_CLUSTER_NUM   FROSTBEE_CHANNEL_COUNT
+#define FROSTBEE_ZONE_OUT_CLUSTER_NUM  0
+
+#define FROSTBEE_ZONE_REPORT_ATTR_COUNT FROSTBEE_CHANNEL_REPORT_ATTR_COUNT
+
+FROSTBEE_DECLARE_SIMPLE_DESC_TYPE(frostbee_zone_simple_desc,
+				  FROSTBEE_ZONE_IN_CLUSTER_NUM,
+				  FROSTBEE_ZONE_OUT_CLUSTER_NUM);
+
+/** @brief Declare cluster list for a Frostbee zone endpoint.
+ *
+ * Uses the attribute lists FROSTBEE_CH_ATTR_LIST(zone, <channel>);
+ * zone must be a literal.
+ */
+#define ZB_DECLARE_FROSTBEE_ZONE_CLUSTER_LIST(cluster_list_name, zone) \
+	zb_zcl_cluster_desc_t cluster_list_name[] =                  \
+	{                                                            \
+		FROSTBEE_CHANNELS(FROSTBEE_CH_CLUSTER_DESC, zone)    \
+	}
+
+/** @brief Declare simple descriptor for a Frostbee zone endpoint. */
+#define ZB_ZCL_DECLARE_FROSTBEE_ZONE_DESC(ep_name, ep_id, in_clust_num, out_clust_num) \
+	frostbee_zone_simple_desc_t simple_desc_##ep_name =                       \
+	{                                                                         \
+		ep_id,                                                            \
+		ZB_AF_HA_PROFILE_ID,                                              \
+		ZB_HA_TEMPERATURE_SENSOR_DEVICE_ID,                               \
+		0, /* device version */                                           \
+		0,                                                                \
+		in_clust_num,                                                     \
+		out_clust_num,                                                    \
+		{                                                                 \
+			FROSTBEE_CHANNELS(FROSTBEE_CH_CLUSTER_ID, 0)              \
+		}                                                                 \
+	}
+
+/** @brief Declare endpoint for a Frostbee zone. */
+#define ZB_DECLARE_FROSTBEE_ZONE_EP(ep_name, ep_id, cluster_list)                 \
+	ZB_ZCL_DECLARE_FROSTBEE_ZONE_DESC(                                        \
+		ep_name, ep_id,                                                   \
+		FROSTBEE_ZONE_IN_CLUSTER_NUM,                                     \
+		FROSTBEE_ZONE_OUT_CLUSTER_NUM);                                   \
+	ZBOSS_DEVICE_DECLARE_REPORTING_CTX(                                       \
+		reporting_info##ep_name,                                           \
+		FROSTBEE_ZONE_REPORT_ATTR_COUNT);                                 \
+	ZB_AF_DECLARE_ENDPOINT_DESC(                                              \
+		ep_name, ep_id,                                                   \
+		ZB_AF_HA_PROFILE_ID,                                              \
+		0,                                                                \
+		NULL,                                                             \
+		ZB_ZCL_ARRAY_SIZE(cluster_list, zb_zcl_cluster_desc_t),           \
+		cluster_list,                                                     \
+		(zb_af_simple_desc_1_1_t *)&simple_desc_##ep_name,                \
+		FROSTBEE_ZONE_REPORT_ATTR_COUNT,                                  \
+		reporting_info##ep_name,                                           \
+		0, NULL)
+
 #endif /* ZB_FROSTBEE_H */
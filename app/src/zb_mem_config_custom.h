@@ -1,7 +1,8 @@
 /*
  * Frostbee - ZBOSS Memory Configuration
  *
- * Minimal memory config for Zigbee End Device.
+ * Minimal memory config for Zigbee End Device.  Router-capable builds
+ * (CONFIG_FROSTBEE_ROUTER_ON_MAINS) size the tables for a router instead.
  *
  * SPDX-License-Identifier: MIT
  */
@@ -9,7 +10,11 @@
 #ifndef ZB_MEM_CONFIG_CUSTOM_H
 #define ZB_MEM_CONFIG_CUSTOM_H 1
 
+#if defined(CONFIG_FROSTBEE_ROUTER_ON_MAINS)
+#define ZB_CONFIG_ROLE_ZR
+#else
 #define ZB_CONFIG_ROLE_ZED
+#endif
 #define ZB_CONFIG_OVERALL_NETWORK_SIZE 16
 #define ZB_CONFIG_LIGHT_TRAFFIC
 #define ZB_CONFIG_APPLICATION_SIMPLE
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Generate (and optionally flash) Frostbee production config images.
+
+Reads one row per device from a CSV file and produces an Intel HEX image
+of the zboss_product_config partition (0xd4000) for each unit, using
+nrfutil's Zigbee production config generator for the standard ZBOSS part
+and appending the Frostbee application block (see
+app/src/prod_config.h).
+
+CSV columns (header row required, empty cells use the defaults given on
+the command line):
+
+    serial,ieee,install_code,channel,tx_power,ext_pan_id,read_interval_s
+
+Missing install codes are generated and written, with their CRC, to
+<out>/install_codes.csv so they can be loaded into the coordinator
+before the units are powered up.
+
+Example:
+
+    frostbee_provision.py devices.csv -o out/ --channel 15 --tx-power 4
+    frostbee_provision.py devices.csv -o out/ --program   # nrfjprog
+"""
+
+import argparse
+import csv
+import os
+import secrets
+import struct
+import subprocess
+import sys
+
+PRODUCT_CONFIG_ADDR = 0xD4000
+
+# Keep in sync with struct frostbee_prod_cfg in app/src/prod_config.h
+PROD_CFG_VERSION = 1
+PROD_CFG_FORMAT = "<BBHI8s"
+
+ALL_CHANNELS = range(11, 27)
+
+
+def crc16_x25(data):
+    """Install code CRC (CRC-16/X-25, as used by Zigbee install codes)."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc ^ 0xFFFF
+
+
+def make_install_code():
+    code = secrets.token_bytes(16)
+    return code + struct.pack("<H", crc16_x25(code))
+
+
+def parse_install_code(text):
+    code = bytes.fromhex(text)
+    if len(code) not in (8, 10, 14, 18):
+        raise ValueError(f"install code has invalid length: {text}")
+    if struct.unpack("<H", code[-2:])[0] != crc16_x25(code[:-2]):
+        raise ValueError(f"install code CRC mismatch: {text}")
+    return code
+
+
+def parse_ext_pan_id(text):
+    if not text:
+        return bytes(8)
+    raw = bytes.fromhex(text.replace(":", ""))
+    if len(raw) != 8:
+        raise ValueError(f"extended PAN ID must be 8 bytes: {text}")
+    # Written MSB first, stored little endian like every ZBOSS address
+    return raw[::-1]
+
+
+def channel_mask(channel):
+    if channel not in ALL_CHANNELS:
+        raise ValueError(f"channel {channel} outside 11-26")
+    return 1 << channel
+
+
+def app_block(row, defaults):
+    channel = int(row.get("channel") or defaults.channel)
+    interval = int(row.get("read_interval_s") or defaults.read_interval or 0)
+    ext_pan = parse_ext_pan_id(row.get("ext_pan_id") or defaults.ext_pan_id)
+    return struct.pack(PROD_CFG_FORMAT, PROD_CFG_VERSION, 0, interval,
+                       channel_mask(channel), ext_pan)
+
+
+def write_yaml(path, row, install_code, defaults):
+    channel = int(row.get("channel") or defaults.channel)
+    tx_power = int(row.get("tx_power") or defaults.tx_power)
+    lines = [
+        f"channel_mask: 0x{channel_mask(channel):08x}",
+        f"tx_power: {tx_power}",
+        f"install_code: {install_code.hex().upper()}",
+        f"mfg_name: {defaults.mfg_name}",
+        f"app_data: {app_block(row, defaults).hex().upper()}",
+    ]
+    if row.get("ieee"):
+        lines.insert(1, f"extended_address: {row['ieee'].replace(':', '').upper()}")
+    with open(path, "w", encoding="ascii") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+def run(cmd, dry_run):
+    print(" ".join(cmd))
+    if not dry_run:
+        subprocess.run(cmd, check=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("csv", help="device list")
+    parser.add_argument("-o", "--out", default="provision_out", help="output directory")
+    parser.add_argument("--channel", type=int, default=15, help="default Zigbee channel")
+    parser.add_argument("--tx-power", type=int, default=4, help="default TX power (dBm)")
+    parser.add_argument("--ext-pan-id", default="", help="default network to join")
+    parser.add_argument("--read-interval", type=int, default=0,
+                        help="default battery-mode read interval (s), 0 = firmware default")
+    parser.add_argument("--mfg-name", default="Frostbee")
+    parser.add_argument("--nrfutil", default="nrfutil")
+    parser.add_argument("--program", action="store_true",
+                        help="flash each image with nrfjprog (serial = J-Link SNR)")
+    parser.add_argument("--dry-run", action="store_true",
+                        help="write YAML files and print commands only")
+    args = parser.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    codes_path = os.path.join(args.out, "install_codes.csv")
+
+    with open(args.csv, newline="", encoding="utf-8") as f, \
+         open(codes_path, "w", newline="", encoding="ascii") as codes_f:
+        codes = csv.writer(codes_f)
+        codes.writerow(["serial", "ieee", "install_code"])
+
+        for row in csv.DictReader(f):
+            serial = row["serial"]
+            code_text = row.get("install_code") or ""
+            install_code = parse_install_code(code_text) if code_text else make_install_code()
+            codes.writerow([serial, row.get("ieee", ""), install_code.hex().upper()])
+
+            yaml_path = os.path.join(args.out, f"{serial}.yaml")
+            hex_path = os.path.join(args.out, f"{serial}.hex")
+            write_yaml(yaml_path, row, install_code, args)
+
+            run([args.nrfutil, "nrf5sdk-tools", "zigbee", "production_config",
+                 yaml_path, hex_path, "--offset", hex(PRODUCT_CONFIG_ADDR)], args.dry_run)
+
+            if args.program:
+                run(["nrfjprog", "--snr", serial, "--program", hex_path,
+                     "--sectorerase", "--verify"], args.dry_run)
+
+    print(f"Install codes: {codes_path}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,347 @@
+#!/usr/bin/env python3
+"""Analyze captured Frostbee report streams from Zigbee2MQTT or MQTT.
+
+Reads local files only and prints, per device:
+
+    reports    attribute reports seen, and the wakes they were sent in
+    interval   median interval between wakes and a histogram
+    gaps       intervals longer than --gap (missed reports, lost parent)
+    dup        repeats of the same frame within --dup-window seconds
+    battery    battery slope (%/day, least squares) and days to empty
+    airtime    estimated transmit airtime per day for the reports seen
+
+Accepted input, mixed freely (format detected per line):
+
+  - Zigbee2MQTT logs (v1 "Zigbee2MQTT:info  2024-01-01 12:00:00: ..." or
+    v2 "[2024-01-01 12:00:00] info: ...").  With log_level debug the
+    "Received Zigbee message ... type 'attributeReport'" lines give one
+    event per radio frame; otherwise "MQTT publish" lines are used.
+  - mosquitto_sub captures with a timestamp, topic and payload per line:
+        mosquitto_sub -t 'zigbee2mqtt/#' -v -F '%I %t %p'
+        mosquitto_sub -t 'zigbee2mqtt/#' -v -F '@s %t %p'
+
+Frostbee devices are recognized from the device list Z2M logs at start-up
+or from a captured zigbee2mqtt/bridge/devices message; without either,
+every device is analyzed unless --device is given.
+
+A sensor sends its temperature, humidity and battery reports back to
+back; reports less than --burst seconds apart count as one wake, and
+intervals and gaps are taken between wakes.
+
+Airtime counts the reports only: the poll traffic of a sleepy device
+(one data request + ACK per keepalive) is not in these captures.
+
+Examples:
+
+    frostbee_report_analyzer.py log.log
+    frostbee_report_analyzer.py capture.txt --since 2025-03-01 --json out.json
+    frostbee_report_analyzer.py old.log new.log --device fridge --gap 5400
+"""
+
+import argparse
+import json
+import re
+import statistics
+import sys
+from collections import defaultdict
+from datetime import datetime, timezone
+
+MQTT_BASE = "zigbee2mqtt"
+
+# Payload keys that change without a new report
+VOLATILE_KEYS = {"linkquality", "last_seen", "elapsed", "update", "update_available"}
+
+# 802.15.4 at 2.4 GHz: 250 kbit/s, 32 us per byte.  A secured ZCL
+# attribute report is ~6 B PHY + 9 B MAC + 8 B NWK + 14 B NWK security
+# + 8 B APS + ~8 B ZCL; the MAC ACK is 11 B plus 192 us turnaround.
+US_PER_BYTE = 32
+DEFAULT_FRAME_BYTES = 55
+ACK_US = 11 * US_PER_BYTE + 192
+
+HISTOGRAM_BINS = [
+    (10, "<10s"), (30, "10-30s"), (60, "30-60s"), (300, "1-5m"),
+    (900, "5-15m"), (3600, "15-60m"), (6 * 3600, "1-6h"), (None, ">6h"),
+]
+
+TS = r"(\d{4}-\d{2}-\d{2}[ T]\d{2}:\d{2}:\d{2}(?:\.\d+)?(?:Z|[+-]\d{2}:?\d{2})?)"
+RE_Z2M_TS = re.compile(r"^(?:\[" + TS + r"\]|Zigbee2MQTT:\w+\s+" + TS + r":)")
+RE_ZIGBEE_MSG = re.compile(
+    r"Received Zigbee message from '(?P<name>[^']+)', type '(?P<type>\w+)', "
+    r"cluster '(?P<cluster>\w+)', data '(?P<data>.*?)' from endpoint (?P<ep>\d+)")
+RE_MQTT_PUBLISH = re.compile(r"MQTT publish: topic '(?P<topic>[^']+)', payload '(?P<payload>.*)'")
+RE_DEVICE_LIST = re.compile(
+    r"(?:^|\s)(?P<name>[^\s:][^:]*?) \((?P<ieee>0x[0-9a-fA-F]{16})\): \S+ - Frostbee")
+RE_CAPTURE = re.compile(r"^(?:" + TS + r"|(?P<epoch>\d{9,}(?:\.\d+)?))\s+(?P<topic>\S+)\s+(?P<payload>.*)$")
+
+
+def parse_ts(text):
+    ts = datetime.fromisoformat(text.replace("Z", "+00:00").replace(" ", "T"))
+    if ts.tzinfo is None:
+        ts = ts.replace(tzinfo=timezone.utc)
+    return ts.timestamp()
+
+
+class Device:
+    def __init__(self, name):
+        self.name = name
+        self.frames = []          # (t, key) per attributeReport frame
+        self.states = []          # (t, key) per MQTT state publish
+        self.frame_battery = []   # (t, percent) from genPowerCfg frames
+        self.state_battery = []   # (t, percent) from MQTT publishes
+
+    def events(self):
+        """Frames if the capture has them, MQTT publishes otherwise."""
+        return sorted(self.frames or self.states)
+
+    def battery(self):
+        """Battery points from the same source as events()."""
+        return sorted(self.frame_battery if self.frames else self.state_battery)
+
+
+class Capture:
+    def __init__(self):
+        self.devices = {}
+        self.frostbee = set()
+
+    def device(self, name):
+        if name not in self.devices:
+            self.devices[name] = Device(name)
+        return self.devices[name]
+
+    def state(self, t, topic, payload):
+        if not topic.startswith(MQTT_BASE + "/"):
+            return
+        name = topic[len(MQTT_BASE) + 1:]
+        if name == "bridge/devices":
+            self.bridge_devices(payload)
+            return
+        if name.startswith("bridge/") or name.rsplit("/", 1)[-1] in ("set", "get", "availability"):
+            return
+        try:
+            data = json.loads(payload)
+        except json.JSONDecodeError:
+            return
+        if not isinstance(data, dict):
+            return
+        dev = self.device(name)
+        key = json.dumps({k: v for k, v in data.items() if k not in VOLATILE_KEYS}, sort_keys=True)
+        dev.states.append((t, key))
+        if isinstance(data.get("battery"), (int, float)):
+            dev.state_battery.append((t, float(data["battery"])))
+
+    def frame(self, t, name, ep, cluster, data):
+        dev = self.device(name)
+        dev.frames.append((t, f"{ep}/{cluster}{data}"))
+        if cluster == "genPowerCfg":
+            try:
+                pct = json.loads(data).get("batteryPercentageRemaining")
+            except (json.JSONDecodeError, AttributeError):
+                pct = None
+            if isinstance(pct, (int, float)) and pct != 0xFF:
+                dev.frame_battery.append((t, pct / 2))
+
+    def bridge_devices(self, payload):
+        try:
+            devices = json.loads(payload)
+        except json.JSONDecodeError:
+            return
+        for d in devices if isinstance(devices, list) else []:
+            if (d.get("definition") or {}).get("vendor") == "Frostbee":
+                self.frostbee.add(d.get("friendly_name"))
+
+    def read(self, path):
+        with open(path, encoding="utf-8", errors="replace") as f:
+            for line in f:
+                self.line(line.rstrip("\n"))
+
+    def line(self, line):
+        m = RE_Z2M_TS.match(line)
+        if m:
+            t = parse_ts(m.group(1) or m.group(2))
+            msg = RE_ZIGBEE_MSG.search(line)
+            if msg and msg["type"] == "attributeReport":
+                self.frame(t, msg["name"], msg["ep"], msg["cluster"], msg["data"])
+                return
+            pub = RE_MQTT_PUBLISH.search(line)
+            if pub:
+                self.state(t, pub["topic"], pub["payload"])
+                return
+        listed = RE_DEVICE_LIST.search(line)
+        if listed:
+            self.frostbee.add(listed["name"])
+            return
+        cap = RE_CAPTURE.match(line)
+        if cap:
+            t = float(cap["epoch"]) if cap["epoch"] else parse_ts(cap.group(1))
+            self.state(t, cap["topic"], cap["payload"])
+
+
+def histogram(intervals):
+    counts = [0] * len(HISTOGRAM_BINS)
+    for dt in intervals:
+        for i, (limit, _) in enumerate(HISTOGRAM_BINS):
+            if limit is None or dt < limit:
+                counts[i] += 1
+                break
+    return {label: n for (_, label), n in zip(HISTOGRAM_BINS, counts)}
+
+
+def battery_slope(points):
+    """Least-squares %/day, or None with less than a day of data."""
+    if len(points) < 3 or points[-1][0] - points[0][0] < 86400:
+        return None
+    t0 = points[0][0]
+    xs = [(t - t0) / 86400 for t, _ in points]
+    ys = [p for _, p in points]
+    mx, my = statistics.fmean(xs), statistics.fmean(ys)
+    sxx = sum((x - mx) ** 2 for x in xs)
+    if sxx == 0:
+        return None
+    return sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / sxx
+
+
+def wakes(times, burst):
+    """Start times of report bursts: reports < burst s apart are one wake."""
+    starts = []
+    for t in times:
+        if not starts or t - last > burst:
+            starts.append(t)
+        last = t
+    return starts
+
+
+def analyze(dev, args):
+    events = [(t, k) for t, k in dev.events() if args.since <= t <= args.until]
+    battery = [(t, p) for t, p in dev.battery() if args.since <= t <= args.until]
+    woke = wakes([t for t, _ in events], args.burst)
+    if len(woke) < 2:
+        return None
+
+    span = events[-1][0] - events[0][0]
+    intervals = [b - a for a, b in zip(woke, woke[1:])]
+    gaps = [(a, b - a) for a, b in zip(woke, woke[1:]) if b - a > args.gap]
+
+    # Z2M publishes the whole state after every frame, so identical
+    # publishes within a burst are normal: duplicates need frames
+    dups = None
+    if dev.frames:
+        dups = 0
+        last_seen = {}
+        for t, key in events:
+            if key in last_seen and t - last_seen[key] <= args.dup_window:
+                dups += 1
+            last_seen[key] = t
+
+    per_day = len(events) / span * 86400 if span > 0 else 0.0
+    airtime_ms = per_day * (args.frame_bytes * US_PER_BYTE + ACK_US) / 1000
+    slope = battery_slope(battery)
+    days_left = None
+    if slope is not None and slope < 0 and battery:
+        days_left = battery[-1][1] / -slope
+
+    return {
+        "device": dev.name,
+        "source": "frames" if dev.frames else "mqtt",
+        "first": datetime.fromtimestamp(events[0][0], timezone.utc).isoformat(),
+        "last": datetime.fromtimestamp(events[-1][0], timezone.utc).isoformat(),
+        "reports": len(events),
+        "wakes": len(woke),
+        "per_hour": per_day / 24,
+        "per_day": per_day,
+        "wakes_per_hour": len(woke) / span * 3600 if span > 0 else 0.0,
+        "median_interval_s": statistics.median(intervals),
+        "histogram": histogram(intervals),
+        "gaps": len(gaps),
+        "longest_gap_s": max((g for _, g in gaps), default=0),
+        "gap_list": [(datetime.fromtimestamp(t, timezone.utc).isoformat(), round(g)) for t, g in gaps],
+        "duplicates": dups,
+        "battery_pct": battery[-1][1] if battery else None,
+        "battery_slope_pct_day": slope,
+        "battery_days_left": days_left,
+        "airtime_ms_day": airtime_ms,
+    }
+
+
+def fmt(value, spec, missing="-"):
+    return missing if value is None else format(value, spec)
+
+
+def print_report(results, show_gaps):
+    print(f"{'device':<24} {'src':<6} {'reports':>7} {'wakes':>6} {'/hour':>6} {'median':>8} {'gaps':>5} "
+          f"{'longest':>8} {'dup':>4} {'batt%':>6} {'%/day':>6} {'days':>6} {'air ms/d':>9}")
+    for r in results:
+        print(f"{r['device'][:24]:<24} {r['source']:<6} {r['reports']:>7} {r['wakes']:>6} "
+              f"{r['wakes_per_hour']:>6.1f} "
+              f"{r['median_interval_s']:>7.0f}s {r['gaps']:>5} {r['longest_gap_s']:>7.0f}s "
+              f"{fmt(r['duplicates'], 'd'):>4} {fmt(r['battery_pct'], '6.1f'):>6} "
+              f"{fmt(r['battery_slope_pct_day'], '6.2f'):>6} {fmt(r['battery_days_left'], '6.0f'):>6} "
+              f"{r['airtime_ms_day']:>9.0f}")
+
+    print()
+    labels = [label for _, label in HISTOGRAM_BINS]
+    print(f"{'wake interval histogram':<24} " + " ".join(f"{label:>6}" for label in labels))
+    for r in results:
+        print(f"{r['device'][:24]:<24} " + " ".join(f"{r['histogram'][label]:>6}" for label in labels))
+
+    if show_gaps:
+        for r in results:
+            for start, length in r["gap_list"]:
+                print(f"gap  {r['device']}: {length} s after {start}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="+", help="Z2M logs and/or mosquitto_sub captures")
+    parser.add_argument("--device", action="append", default=[],
+                        help="analyze only this friendly name (repeatable)")
+    parser.add_argument("--since", type=parse_ts, default=float("-inf"),
+                        help="ignore events before this time (ISO 8601, UTC if no offset)")
+    parser.add_argument("--until", type=parse_ts, default=float("inf"),
+                        help="ignore events after this time")
+    parser.add_argument("--gap", type=float, default=5400,
+                        help="interval counted as a gap, seconds (default: 5400, 1.5x the "
+                             "1 h maximum report interval)")
+    parser.add_argument("--burst", type=float, default=10,
+                        help="reports this close belong to one wake, seconds (default: 10)")
+    parser.add_argument("--dup-window", type=float, default=5,
+                        help="identical reports this close are duplicates, seconds (default: 5)")
+    parser.add_argument("--frame-bytes", type=int, default=DEFAULT_FRAME_BYTES,
+                        help=f"on-air bytes per report (default: {DEFAULT_FRAME_BYTES})")
+    parser.add_argument("--show-gaps", action="store_true", help="list every gap")
+    parser.add_argument("--json", help="also write the results to this file")
+    args = parser.parse_args()
+
+    capture = Capture()
+    for path in args.files:
+        capture.read(path)
+
+    if args.device:
+        names = args.device
+    elif capture.frostbee:
+        names = sorted(capture.frostbee)
+    else:
+        names = sorted(capture.devices)
+
+    results = []
+    for name in names:
+        if name in capture.devices:
+            r = analyze(capture.devices[name], args)
+            if r is not None:
+                results.append(r)
+
+    if not results:
+        print("no device with at least two reports found", file=sys.stderr)
+        return 1
+
+    print_report(results, args.show_gaps)
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump(results, f, indent=2)
+            f.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Drive the Frostbee manufacturing self-test on many dongles at once.
+
+Each dongle is powered up with the button held, enumerates as a USB CDC
+device named "Frostbee" and prints one line:
+
+    SELFTEST {"v":2,"pass":1,"ms":37,"id":"...","sht":[{...},...],...}
+
+"sht" has one entry per SHT4x zone (format 1 had a single object).
+
+This script opens every matching port in parallel, asserts DTR, collects
+the result lines and prints a pass/fail table.  Results are appended to
+a CSV log.  The exit status is non-zero if any unit fails or does not
+answer.
+
+Requires pyserial.
+
+Examples:
+
+    frostbee_selftest.py --scan --log results.csv
+    frostbee_selftest.py /dev/ttyACM0 /dev/ttyACM1
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import json
+import os
+import sys
+import time
+
+import serial
+from serial.tools import list_ports
+
+RESULT_PREFIX = "SELFTEST "
+PRODUCT = "Frostbee"
+
+CSV_FIELDS = ["time", "port", "id", "pass", "ms", "sht_ok", "sht_sn", "t", "h",
+              "adc_ok", "vbat", "open", "led_ok", "radio_ok", "ed", "ch", "error"]
+
+
+def scan_ports():
+    return sorted(p.device for p in list_ports.comports() if p.product == PRODUCT)
+
+
+def run_unit(port, timeout):
+    """Return the parsed result dict for one dongle, or an error dict."""
+    deadline = time.monotonic() + timeout
+    try:
+        with serial.Serial(port, 115200, timeout=0.1) as ser:
+            ser.dtr = True
+            buf = b""
+            while time.monotonic() < deadline:
+                buf += ser.read(256)
+                while b"\n" in buf:
+                    line, buf = buf.split(b"\n", 1)
+                    text = line.decode("ascii", "replace").strip()
+                    if text.startswith(RESULT_PREFIX):
+                        return json.loads(text[len(RESULT_PREFIX):])
+    except (serial.SerialException, json.JSONDecodeError) as exc:
+        return {"pass": 0, "error": str(exc)}
+    return {"pass": 0, "error": "timeout"}
+
+
+def sht_zones(res):
+    """SHT4x results as a list, one per zone, for either format."""
+    sht = res.get("sht", [])
+    return sht if isinstance(sht, list) else [sht]
+
+
+def csv_row(port, res):
+    """One CSV row; per-zone SHT4x values are space-separated."""
+    zones = sht_zones(res)
+    adc = res.get("adc", {})
+    radio = res.get("radio", {})
+    return {
+        "time": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "port": port,
+        "id": res.get("id", ""),
+        "pass": res.get("pass", 0),
+        "ms": res.get("ms", ""),
+        "sht_ok": int(all(z.get("ok") for z in zones)) if zones else "",
+        "sht_sn": " ".join(str(z.get("sn", "")) for z in zones),
+        "t": " ".join(str(z.get("t", "")) for z in zones),
+        "h": " ".join(str(z.get("h", "")) for z in zones),
+        "adc_ok": adc.get("ok", ""),
+        "vbat": adc.get("vbat", ""),
+        "open": adc.get("open", ""),
+        "led_ok": res.get("led", {}).get("ok", ""),
+        "radio_ok": radio.get("ok", ""),
+        "ed": radio.get("ed", ""),
+        "ch": radio.get("ch", ""),
+        "error": res.get("error", ""),
+    }
+
+
+def failed_checks(res):
+    if "error" in res:
+        return res["error"]
+    zones = sht_zones(res)
+    failed = [f"sht{i + 1}" if len(zones) > 1 else "sht"
+              for i, z in enumerate(zones) if not z.get("ok")]
+    if not zones:
+        failed.append("sht")
+    failed += [k for k in ("adc", "led", "radio") if not res.get(k, {}).get("ok")]
+    return ",".join(failed)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("ports", nargs="*", help="serial ports to test")
+    parser.add_argument("--scan", action="store_true",
+                        help=f"test every port whose USB product is '{PRODUCT}'")
+    parser.add_argument("--timeout", type=float, default=5.0,
+                        help="seconds to wait for each unit (default: 5)")
+    parser.add_argument("--log", help="append results to this CSV file")
+    args = parser.parse_args()
+
+    ports = list(args.ports)
+    if args.scan:
+        ports += [p for p in scan_ports() if p not in ports]
+    if not ports:
+        parser.error("no ports given and none found")
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=len(ports)) as pool:
+        results = dict(zip(ports, pool.map(lambda p: run_unit(p, args.timeout), ports)))
+
+    failures = 0
+    for port, res in results.items():
+        ok = bool(res.get("pass"))
+        failures += not ok
+        detail = "" if ok else f"  ({failed_checks(res)})"
+        print(f"{port:<16} {res.get('id', '-'):<17} {'PASS' if ok else 'FAIL'}"
+              f"  {res.get('ms', '-')} ms{detail}")
+
+    if args.log:
+        new_file = not os.path.exists(args.log)
+        with open(args.log, "a", newline="", encoding="ascii") as f:
+            writer = csv.DictWriter(f, fieldnames=CSV_FIELDS)
+            if new_file:
+                writer.writeheader()
+            for port, res in results.items():
+                writer.writerow(csv_row(port, res))
+
+    print(f"{len(ports) - failures}/{len(ports)} passed")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Report the Frostbee image footprint and check it against budgets.
+
+Run by the build when CONFIG_FROSTBEE_SIZE_BUDGET is enabled (see
+prj_release.conf), or by hand on any zephyr.elf:
+
+    flash      bytes written to flash (all loadable file data)
+    ram        static RAM, _image_ram_start .. _image_ram_end
+    retained   RAM left powered in System ON idle: every nRF52840 RAM
+               section that starts below _image_ram_end, since the
+               RAM power-down library only switches off whole sections
+               above the image
+
+The exit status is non-zero if any figure exceeds its budget.
+
+Requires pyelftools (already a Zephyr build dependency).
+
+Examples:
+
+    frostbee_size_budget.py --elf build/app/zephyr/zephyr.elf
+    frostbee_size_budget.py --elf zephyr.elf --flash-kb 367 --ram-kb 88 \\
+        --retained-kb 96 --json size.json
+"""
+
+import argparse
+import json
+import sys
+
+from elftools.elf.constants import P_FLAGS
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+RAM_BASE = 0x20000000
+
+# nRF52840 RAM power sections: RAM0..RAM7 hold 2 x 4 KB each, RAM8 6 x 32 KB
+RAM_SECTIONS = [4096] * 16 + [32768] * 6
+
+
+def symbol_values(elf, names):
+    symtab = elf.get_section_by_name(".symtab")
+    if not isinstance(symtab, SymbolTableSection):
+        return {}
+    found = {}
+    for name in names:
+        syms = symtab.get_symbol_by_name(name)
+        if syms:
+            found[name] = syms[0]["st_value"]
+    return found
+
+
+def measure(path):
+    with open(path, "rb") as f:
+        elf = ELFFile(f)
+        loads = [seg for seg in elf.iter_segments() if seg["p_type"] == "PT_LOAD"]
+
+        flash = sum(seg["p_filesz"] for seg in loads)
+
+        syms = symbol_values(elf, ["_image_ram_start", "_image_ram_end"])
+        if len(syms) == 2:
+            ram_start = syms["_image_ram_start"]
+            ram_end = syms["_image_ram_end"]
+        else:
+            ram = [seg for seg in loads
+                   if seg["p_vaddr"] >= RAM_BASE and seg["p_flags"] & P_FLAGS.PF_W]
+            ram_start = min(seg["p_vaddr"] for seg in ram)
+            ram_end = max(seg["p_vaddr"] + seg["p_memsz"] for seg in ram)
+
+    retained = 0
+    addr = RAM_BASE
+    for size in RAM_SECTIONS:
+        if addr >= ram_end:
+            break
+        retained += size
+        addr += size
+
+    return {"flash": flash, "ram": ram_end - ram_start, "retained": retained,
+            "ram_end": ram_end}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--elf", required=True, help="linked zephyr.elf")
+    parser.add_argument("--flash-kb", type=int, help="flash budget")
+    parser.add_argument("--ram-kb", type=int, help="static RAM budget")
+    parser.add_argument("--retained-kb", type=int, help="retained RAM budget")
+    parser.add_argument("--json", help="also write the figures to this file")
+    args = parser.parse_args()
+
+    sizes = measure(args.elf)
+    budgets = {"flash": args.flash_kb, "ram": args.ram_kb,
+               "retained": args.retained_kb}
+
+    failed = []
+    print("Frostbee footprint:")
+    for key, used in (("flash", sizes["flash"]), ("ram", sizes["ram"]),
+                      ("retained", sizes["retained"])):
+        budget_kb = budgets[key]
+        if budget_kb is None:
+            print(f"  {key:<9}{used / 1024:8.1f} KB")
+            continue
+        budget = budget_kb * 1024
+        status = "ok" if used <= budget else "OVER"
+        print(f"  {key:<9}{used / 1024:8.1f} KB of {budget_kb:5d} KB "
+              f"({100 * used / budget:5.1f}%)  {status}")
+        if used > budget:
+            failed.append(key)
+    print(f"  RAM image ends at 0x{sizes['ram_end']:08x}")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"sizes": sizes, "budgets_kb": budgets, "over": failed},
+                      f, indent=2)
+            f.write("\n")
+
+    if failed:
+        print(f"error: over budget: {', '.join(failed)}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
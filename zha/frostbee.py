@@ -1,8 +1,10 @@
 """Frostbee FBE_TH_1 - Zigbee temperature & humidity sensor quirk for ZHA."""
 
+import zigpy.types as t
 from zigpy.profiles import zha
-from zigpy.quirks import CustomDevice
-from zigpy.zcl.clusters.general import Basic, Identify, PowerConfiguration
+from zigpy.quirks import CustomCluster, CustomDevice
+from zigpy.zcl import foundation
+from zigpy.zcl.clusters.general import Basic, Groups, Identify, Ota, PowerConfiguration
 from zigpy.zcl.clusters.measurement import RelativeHumidity, TemperatureMeasurement
 
 from zhaquirks.const import (
@@ -15,44 +17,227 @@ from zhaquirks.const import (
 )
 
 
+class FrostbeeConfigCluster(CustomCluster):
+    """Versioned settings (app/src/fleet_config.h); writing config_version commits."""
+
+    cluster_id = 0xFC00
+    name = "Frostbee Config"
+    ep_attribute = "frostbee_config"
+
+    class AttributeDefs(CustomCluster.AttributeDefs):
+        read_interval = foundation.ZCLAttributeDef(id=0x0000, type=t.uint16_t)
+        mains_read_interval = foundation.ZCLAttributeDef(id=0x0001, type=t.uint16_t)
+        config_version = foundation.ZCLAttributeDef(id=0x00FF, type=t.uint16_t)
+
+
+class SleepyReportingMixin:
+    """Configure reporting with values tuned for a sleepy sensor.
+
+    REPORTING maps attribute name -> (min s, max s, reportable change);
+    attributes not listed (e.g. BatteryVoltage, which the firmware does
+    not report) are acknowledged locally instead of going over the air.
+    """
+
+    REPORTING = {}
+
+    async def configure_reporting_multiple(self, attributes, manufacturer=None, **kwargs):
+        tuned = {}
+        for attr in attributes:
+            name = attr if isinstance(attr, str) else self.attributes[attr].name
+            if name in self.REPORTING:
+                tuned[name] = self.REPORTING[name]
+        if not tuned:
+            return [[foundation.ConfigureReportingResponseRecord(foundation.Status.SUCCESS)]]
+        return await super().configure_reporting_multiple(tuned, manufacturer=manufacturer, **kwargs)
+
+
+class FrostbeePowerConfiguration(SleepyReportingMixin, CustomCluster, PowerConfiguration):
+    """Battery pack constants answered locally, percentage reporting only."""
+
+    _CONSTANT_ATTRIBUTES = {
+        PowerConfiguration.AttributeDefs.battery_size.id: PowerConfiguration.BatterySize.AA,
+        PowerConfiguration.AttributeDefs.battery_quantity.id: 3,
+        PowerConfiguration.AttributeDefs.battery_rated_voltage.id: 15,
+    }
+
+    REPORTING = {"battery_percentage_remaining": (3600, 43200, 2)}
+
+
+class FrostbeeTemperature(SleepyReportingMixin, CustomCluster, TemperatureMeasurement):
+    """0.2 C reportable change, 1 h heartbeat."""
+
+    REPORTING = {"measured_value": (60, 3600, 20)}
+
+
+class FrostbeeHumidity(SleepyReportingMixin, CustomCluster, RelativeHumidity):
+    """1 %RH reportable change, 1 h heartbeat."""
+
+    REPORTING = {"measured_value": (60, 3600, 100)}
+
+
+# Endpoint 1 without and with the fleet configuration cluster
+# (CONFIG_FROSTBEE_FLEET_CONFIG, Groups + 0xFC00).  Units built before
+# it, or with it disabled, keep matching the plain variants.
+EP1_SIGNATURE = {
+    PROFILE_ID: zha.PROFILE_ID,
+    DEVICE_TYPE: 0x0302,
+    INPUT_CLUSTERS: [
+        Basic.cluster_id,
+        Identify.cluster_id,
+        PowerConfiguration.cluster_id,
+        TemperatureMeasurement.cluster_id,
+        RelativeHumidity.cluster_id,
+    ],
+    OUTPUT_CLUSTERS: [
+        Identify.cluster_id,
+    ],
+}
+
+EP1_FLEET_SIGNATURE = {
+    **EP1_SIGNATURE,
+    INPUT_CLUSTERS: [
+        Basic.cluster_id,
+        Identify.cluster_id,
+        PowerConfiguration.cluster_id,
+        Groups.cluster_id,
+        FrostbeeConfigCluster.cluster_id,
+        TemperatureMeasurement.cluster_id,
+        RelativeHumidity.cluster_id,
+    ],
+}
+
+EP1_REPLACEMENT = {
+    PROFILE_ID: zha.PROFILE_ID,
+    DEVICE_TYPE: 0x0302,
+    INPUT_CLUSTERS: [
+        Basic.cluster_id,
+        Identify.cluster_id,
+        FrostbeePowerConfiguration,
+        FrostbeeTemperature,
+        FrostbeeHumidity,
+    ],
+    OUTPUT_CLUSTERS: [
+        Identify.cluster_id,
+    ],
+}
+
+EP1_FLEET_REPLACEMENT = {
+    **EP1_REPLACEMENT,
+    INPUT_CLUSTERS: [
+        Basic.cluster_id,
+        Identify.cluster_id,
+        FrostbeePowerConfiguration,
+        Groups.cluster_id,
+        FrostbeeConfigCluster,
+        FrostbeeTemperature,
+        FrostbeeHumidity,
+    ],
+}
+
+# OTA client endpoint (prj_ota.conf)
+EP10_OTA = {
+    PROFILE_ID: zha.PROFILE_ID,
+    INPUT_CLUSTERS: [
+        Basic.cluster_id,
+    ],
+    OUTPUT_CLUSTERS: [
+        Ota.cluster_id,
+    ],
+}
+
+# Second zone (FBE_TH_MZ)
+EP2_ZONE_SIGNATURE = {
+    PROFILE_ID: zha.PROFILE_ID,
+    DEVICE_TYPE: 0x0302,
+    INPUT_CLUSTERS: [
+        TemperatureMeasurement.cluster_id,
+        RelativeHumidity.cluster_id,
+    ],
+    OUTPUT_CLUSTERS: [],
+}
+
+EP2_ZONE_REPLACEMENT = {
+    **EP2_ZONE_SIGNATURE,
+    INPUT_CLUSTERS: [
+        FrostbeeTemperature,
+        FrostbeeHumidity,
+    ],
+}
+
+
 class FrostbeeTH1(CustomDevice):
     """Frostbee temperature & humidity sensor (SHT40)."""
 
     signature = {
         MODELS_INFO: [("Frostbee", "FBE_TH_1")],
-        ENDPOINTS: {
-            1: {
-                PROFILE_ID: zha.PROFILE_ID,
-                DEVICE_TYPE: 0x0302,
-                INPUT_CLUSTERS: [
-                    Basic.cluster_id,
-                    Identify.cluster_id,
-                    PowerConfiguration.cluster_id,
-                    TemperatureMeasurement.cluster_id,
-                    RelativeHumidity.cluster_id,
-                ],
-                OUTPUT_CLUSTERS: [
-                    Identify.cluster_id,
-                ],
-            }
-        },
+        ENDPOINTS: {1: EP1_SIGNATURE},
+    }
+
+    replacement = {
+        ENDPOINTS: {1: EP1_REPLACEMENT},
+    }
+
+
+class FrostbeeTH1Fleet(CustomDevice):
+    """Frostbee FBE_TH_1 with the fleet configuration cluster."""
+
+    signature = {
+        MODELS_INFO: [("Frostbee", "FBE_TH_1")],
+        ENDPOINTS: {1: EP1_FLEET_SIGNATURE},
+    }
+
+    replacement = {
+        ENDPOINTS: {1: EP1_FLEET_REPLACEMENT},
+    }
+
+
+class FrostbeeTH1Ota(CustomDevice):
+    """Frostbee FBE_TH_1 built with prj_ota.conf (OTA client on endpoint 10)."""
+
+    signature = {
+        MODELS_INFO: [("Frostbee", "FBE_TH_1")],
+        ENDPOINTS: {1: EP1_SIGNATURE, 10: EP10_OTA},
+    }
+
+    replacement = {
+        ENDPOINTS: {1: EP1_REPLACEMENT, 10: EP10_OTA},
+    }
+
+
+class FrostbeeTH1FleetOta(CustomDevice):
+    """Frostbee FBE_TH_1 with fleet configuration and the OTA client."""
+
+    signature = {
+        MODELS_INFO: [("Frostbee", "FBE_TH_1")],
+        ENDPOINTS: {1: EP1_FLEET_SIGNATURE, 10: EP10_OTA},
+    }
+
+    replacement = {
+        ENDPOINTS: {1: EP1_FLEET_REPLACEMENT, 10: EP10_OTA},
+    }
+
+
+class FrostbeeTHMultiZone(CustomDevice):
+    """Frostbee FBE_TH_MZ: one SHT4x per endpoint (two-zone build)."""
+
+    signature = {
+        MODELS_INFO: [("Frostbee", "FBE_TH_MZ")],
+        ENDPOINTS: {1: EP1_SIGNATURE, 2: EP2_ZONE_SIGNATURE},
+    }
+
+    replacement = {
+        ENDPOINTS: {1: EP1_REPLACEMENT, 2: EP2_ZONE_REPLACEMENT},
+    }
+
+
+class FrostbeeTHMultiZoneFleet(CustomDevice):
+    """Frostbee FBE_TH_MZ with the fleet configuration cluster."""
+
+    signature = {
+        MODELS_INFO: [("Frostbee", "FBE_TH_MZ")],
+        ENDPOINTS: {1: EP1_FLEET_SIGNATURE, 2: EP2_ZONE_SIGNATURE},
     }
 
     replacement = {
-        ENDPOINTS: {
-            1: {
-                PROFILE_ID: zha.PROFILE_ID,
-                DEVICE_TYPE: 0x0302,
-                INPUT_CLUSTERS: [
-                    Basic.cluster_id,
-                    Identify.cluster_id,
-                    PowerConfiguration.cluster_id,
-                    TemperatureMeasurement.cluster_id,
-                    RelativeHumidity.cluster_id,
-                ],
-                OUTPUT_CLUSTERS: [
-                    Identify.cluster_id,
-                ],
-            }
-        },
+        ENDPOINTS: {1: EP1_FLEET_REPLACEMENT, 2: EP2_ZONE_REPLACEMENT},
     }
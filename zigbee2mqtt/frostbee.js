@@ -1,9 +1,244 @@
+import {Zcl} from 'zigbee-herdsman';
+import * as exposes from 'zigbee-herdsman-converters/lib/exposes';
 import * as m from 'zigbee-herdsman-converters/lib/modernExtend';
+import * as reporting from 'zigbee-herdsman-converters/lib/reporting';
 
-export default {
-    zigbeeModel: ['FBE_TH_1'],
-    model: 'FBE_TH_1',
-    vendor: 'Frostbee',
-    description: 'Temperature & humidity sensor (SHT40)',
-    extend: [m.battery(), m.temperature(), m.humidity()],
-};
\ No newline at end of file
+const e = exposes.presets;
+const ea = exposes.access;
+
+// Multi-zone firmware (several SHT4x in the devicetree) puts zone N on
+// endpoint N.  Extend this map if you build with more than two sensors.
+const zoneEndpoints = {zone1: 1, zone2: 2};
+const zoneNames = Object.keys(zoneEndpoints);
+
+// Firmware config cluster (app/src/fleet_config.h) on endpoint 1.  Writes
+// use numeric IDs: group writes do not know device custom clusters.
+const CONFIG_CLUSTER = 0xfc00;
+const CONFIG_ENDPOINT = 1;
+const CONFIG_ATTR = {readInterval: 0x0000, mainsReadInterval: 0x0001, configVersion: 0x00ff};
+const UINT16 = Zcl.DataType.UINT16;
+
+// Shortest interval the firmware accepts (0 = default); a rejected
+// interval also rejects the version written with it
+const MIN_INTERVAL_S = 5;
+
+// A device that missed a group push is checked at most this often, on
+// the back of one of its own reports (it is awake and polling then)
+const VERIFY_INTERVAL_MS = 10 * 60 * 1000;
+
+// Integer keys iterate in ascending order, so ConfigVersion (0x00ff) is
+// written last and commits the values before it.
+function configPayload(cfg) {
+    return {
+        [CONFIG_ATTR.readInterval]: {value: cfg.read_interval, type: UINT16},
+        [CONFIG_ATTR.mainsReadInterval]: {value: cfg.mains_read_interval, type: UINT16},
+        [CONFIG_ATTR.configVersion]: {value: cfg.version, type: UINT16},
+    };
+}
+
+async function verifyConfig(device, logger) {
+    const state = device.meta.frostbeeConfig;
+    if (!state || state.confirmed === state.desired.version) {
+        return;
+    }
+    const now = Date.now();
+    if (now - (state.lastCheck ?? 0) < VERIFY_INTERVAL_MS) {
+        return;
+    }
+    state.lastCheck = now;
+
+    const endpoint = device.getEndpoint(CONFIG_ENDPOINT);
+    try {
+        const rsp = await endpoint.read('frostbeeConfig', ['configVersion']);
+        if (rsp.configVersion !== state.desired.version) {
+            // Missed the group push (sleepy devices usually do): unicast
+            await endpoint.write(CONFIG_CLUSTER, configPayload(state.desired));
+        }
+        state.confirmed = state.desired.version;
+    } catch (error) {
+        logger?.debug(`Frostbee config check for ${device.ieeeAddr} failed: ${error}`);
+    }
+    device.save();
+}
+
+const fzConfig = {
+    cluster: 'frostbeeConfig',
+    type: ['attributeReport', 'readResponse'],
+    convert: (model, msg, publish, options, meta) => {
+        if (msg.data.configVersion === undefined) {
+            return;
+        }
+        const state = msg.device.meta.frostbeeConfig;
+        if (state && msg.data.configVersion === state.desired.version) {
+            state.confirmed = state.desired.version;
+            msg.device.save();
+        }
+        return {config_version: msg.data.configVersion};
+    },
+};
+
+// Piggy-backs the version check on regular temperature reports
+const fzConfigVerify = {
+    cluster: 'msTemperatureMeasurement',
+    type: ['attributeReport'],
+    convert: (model, msg, publish, options, meta) => {
+        verifyConfig(msg.device, meta.logger);
+    },
+};
+
+const tzConfig = {
+    key: ['frostbee_config'],
+    convertSet: async (entity, key, value, meta) => {
+        // A group publish writes once to the whole group
+        const members = 'members' in entity ? entity.members : [entity];
+        const devices = members
+            .filter((ep) => ep.ID === CONFIG_ENDPOINT)
+            .map((ep) => ep.getDevice())
+            .filter((device) => device.manufacturerName === 'Frostbee');
+
+        // One version for all members, newer than any of them has seen
+        const previous = devices.map((d) => d.meta.frostbeeConfig?.desired).filter(Boolean);
+        const base = previous[0] ?? {read_interval: 0, mains_read_interval: 0};
+        const version = (Math.max(0, ...previous.map((cfg) => cfg.version)) % 0xffff) + 1;
+        const desired = {
+            read_interval: value.read_interval ?? base.read_interval,
+            mains_read_interval: value.mains_read_interval ?? base.mains_read_interval,
+            version,
+        };
+        for (const interval of [desired.read_interval, desired.mains_read_interval]) {
+            if (interval !== 0 && interval < MIN_INTERVAL_S) {
+                throw new Error(`Read interval must be 0 or at least ${MIN_INTERVAL_S} s`);
+            }
+        }
+
+        await entity.write(CONFIG_CLUSTER, configPayload(desired), {disableDefaultResponse: true});
+
+        for (const device of devices) {
+            const state = device.meta.frostbeeConfig;
+            device.meta.frostbeeConfig = {desired, confirmed: state?.confirmed ?? null, lastCheck: 0};
+            device.save();
+        }
+
+        return {state: {frostbee_config: {read_interval: desired.read_interval,
+            mains_read_interval: desired.mains_read_interval}}};
+    },
+};
+
+function fleetConfig() {
+    return {
+        fromZigbee: [fzConfig, fzConfigVerify],
+        toZigbee: [tzConfig],
+        exposes: [
+            e.composite('frostbee_config', 'frostbee_config', ea.SET)
+                .withDescription('Sensor read intervals (0 = firmware default); can be set per group')
+                .withFeature(e.numeric('read_interval', ea.SET).withUnit('s').withValueMin(0).withValueMax(65535)
+                    .withDescription('On batteries'))
+                .withFeature(e.numeric('mains_read_interval', ea.SET).withUnit('s').withValueMin(0).withValueMax(65535)
+                    .withDescription('On USB/mains power')),
+            e.numeric('config_version', ea.STATE).withDescription('Configuration version active on the device'),
+        ],
+        isModernExtend: true,
+    };
+}
+
+// Reporting for a sleepy sensor.  Only attributes the firmware marks
+// reportable are configured: BatteryVoltage is read-only and not
+// reportable, so configuring it only fails and gets retried.
+const REPORTING = {
+    msTemperatureMeasurement: [
+        {attribute: 'measuredValue', minimumReportInterval: 60, maximumReportInterval: 3600, reportableChange: 20},
+    ],
+    msRelativeHumidity: [
+        {attribute: 'measuredValue', minimumReportInterval: 60, maximumReportInterval: 3600, reportableChange: 100},
+    ],
+    genPowerCfg: [
+        {attribute: 'batteryPercentageRemaining', minimumReportInterval: 3600, maximumReportInterval: 43200,
+            reportableChange: 2},
+    ],
+};
+
+// One Read Attributes per cluster for the initial state (cluster IDs:
+// herdsman resolves the custom cluster name only per device)
+const INITIAL_READS = [
+    [0x0402, 'msTemperatureMeasurement', ['measuredValue']],
+    [0x0405, 'msRelativeHumidity', ['measuredValue']],
+    [0x0001, 'genPowerCfg', ['batteryVoltage', 'batteryPercentageRemaining']],
+    [CONFIG_CLUSTER, 'frostbeeConfig', ['readInterval', 'mainsReadInterval', 'configVersion']],
+];
+
+// Replaces the per-extend configure steps with one ZDO Bind, one
+// Configure Reporting and one Read Attributes per cluster and endpoint
+// (ZDO Bind has no multi-cluster form), without the failing
+// batteryVoltage reporting request and its retries.  The firmware polls
+// continuously for CONFIG_FROSTBEE_FAST_POLL_WINDOW_S after joining, and
+// after a short button press, so run (or re-run) this inside that window.
+function sleepyConfigure() {
+    return {
+        configure: [
+            async (device, coordinatorEndpoint, definition) => {
+                for (const endpoint of device.endpoints) {
+                    const clusters = Object.keys(REPORTING).filter((c) => endpoint.supportsInputCluster(c));
+                    if (clusters.length === 0) {
+                        continue;
+                    }
+                    await reporting.bind(endpoint, coordinatorEndpoint, clusters);
+                    for (const cluster of clusters) {
+                        await endpoint.configureReporting(cluster, REPORTING[cluster]);
+                    }
+                    for (const [id, cluster, attributes] of INITIAL_READS) {
+                        if (endpoint.inputClusters.includes(id)) {
+                            await endpoint.read(cluster, attributes);
+                        }
+                    }
+                }
+            },
+        ],
+        isModernExtend: true,
+    };
+}
+
+const configCluster = m.deviceAddCustomCluster('frostbeeConfig', {
+    ID: CONFIG_CLUSTER,
+    attributes: {
+        readInterval: {ID: CONFIG_ATTR.readInterval, type: UINT16},
+        mainsReadInterval: {ID: CONFIG_ATTR.mainsReadInterval, type: UINT16},
+        configVersion: {ID: CONFIG_ATTR.configVersion, type: UINT16},
+    },
+    commands: {},
+    commandsResponse: {},
+});
+
+export default [
+    {
+        zigbeeModel: ['FBE_TH_1'],
+        model: 'FBE_TH_1',
+        vendor: 'Frostbee',
+        description: 'Temperature & humidity sensor (SHT40)',
+        extend: [
+            configCluster,
+            m.battery({voltage: true, percentageReporting: false}),
+            m.temperature({reporting: false}),
+            m.humidity({reporting: false}),
+            fleetConfig(),
+            sleepyConfigure(),
+        ],
+        // Only firmware built with prj_ota.conf exposes the OTA client endpoint
+        ota: true,
+    },
+    {
+        zigbeeModel: ['FBE_TH_MZ'],
+        model: 'FBE_TH_MZ',
+        vendor: 'Frostbee',
+        description: 'Multi-zone temperature & humidity sensor (SHT40)',
+        extend: [
+            configCluster,
+            m.deviceEndpoints({endpoints: zoneEndpoints}),
+            m.battery({voltage: true, percentageReporting: false}),
+            m.temperature({endpointNames: zoneNames, reporting: false}),
+            m.humidity({endpointNames: zoneNames, reporting: false}),
+            fleetConfig(),
+            sleepyConfigure(),
+        ],
+        ota: true,
+    },
+];